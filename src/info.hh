@@ -64,7 +64,8 @@ inline void program_init(OB::Parg& pg)
   pg.name("gentone").version("0.1.2 (24.03.2020)");
   pg.description("Generate a tone from a note or frequency.");
 
-  pg.usage("[Hz|A-G[b#]0-8] [--colour=<on|off|auto>] [-l|--loop] [--char=<char>] [--a4=<Hz>] [--speed=<m/s>] [-w|--wave=<sine|square|triangle|saw>] [-t|--time=<seconds>] [-c|--channels=<1|2|mono|stereo|left|right>] [-r|--rate=<Hz>] [-a|--amplitude=<0.0-1.0>] [-o|--output=<file>]");
+  pg.usage("[Hz|A-G[b#]0-8] [--colour=<on|off|auto>] [-l|--loop] [--char=<char>] [--a4=<Hz>] [--sos=<m/s>] [-w|--wave=<sine|square|triangle|saw|additive|fm|white|pink|brown>] [--harmonics=<1-4096>] [--rolloff=<exponent>] [--ratio=<carrier,modulator,...>] [--index=<radians,...>] [--feedback=<radians>] [--table=<file>] [--phase=<fixed|float>] [--precision=<exact|polynomial|table>] [--antialias=<none|polyblep>] [--oversample=<1|2|4|8>] [-t|--time=<seconds|inf>] [-c|--channels=<1|2|mono|stereo|left|right>] [-r|--rate=<Hz>] [--rates=<Hz,...>] [-a|--amplitude=<0.0-1.0>] [-o|--output=<file|->] [--format=<s16le|s24le|s32le|f32le>] [--dither=<none|tpdf>] [--seed=<N>] [--shaping=<none|first|lipshitz>] [-j|--jobs=<N>] [--kernel=<auto|scalar|sse2|avx2|avx512>] [--bench] [--check]");
+  pg.usage("[--colour=<on|off|auto>] [--kernel=<auto|scalar|sse2|avx2|avx512>] --cpu-info");
   pg.usage("[--colour=<on|off|auto>] -h|--help");
   pg.usage("[--colour=<on|off|auto>] -v|--version");
   pg.usage("[--colour=<on|off|auto>] --license");
@@ -78,6 +79,36 @@ inline void program_init(OB::Parg& pg)
       "Generate a 3 second stereo triangle wave with a frequency of 440Hz."},
     {"gentone --time 1 --output sine.wav C#7",
       "Generate a 1 second mono sine wave using the musical note C#7 and save the tone to the output file 'sine.wav'."},
+    {"gentone --time 3600 --jobs 0 --output tone.wav 441",
+      "Generate a 1 hour mono sine wave with a frequency of 441Hz on every hardware thread and save the tone to the output file 'tone.wav'."},
+    {"gentone --time 10 --format s24le --output tone.wav 440",
+      "Generate a 10 second mono sine wave with a frequency of 440Hz and save it as 24-bit samples to the output file 'tone.wav'."},
+    {"gentone --time 10 --rates 48000,96000,192000 --output tone.wav 440",
+      "Generate a 10 second mono sine wave with a frequency of 440Hz from one synthesis pass and save it at 44100Hz to 'tone.wav' and resampled to 'tone-48000.wav', 'tone-96000.wav', and 'tone-192000.wav'."},
+    {"gentone --time inf --output - --format f32le 440 | aplay -f FLOAT_LE -r 44100",
+      "Stream a 440Hz mono sine wave as raw 32-bit float samples to another program until interrupted."},
+    {"gentone --amplitude 0.001 --dither tpdf --shaping lipshitz --output quiet.wav 1000",
+      "Generate a 1 second quiet mono sine wave with a frequency of 1000Hz, with noise-shaped dither instead of quantization distortion, and save the tone to the output file 'quiet.wav'."},
+    {"gentone --wave saw --antialias polyblep --output saw.wav C7",
+      "Generate a 1 second mono saw wave using the musical note C7 with its aliasing suppressed and save the tone to the output file 'saw.wav'."},
+    {"gentone --wave additive --harmonics 32 --rolloff 1.5 --output additive.wav C3",
+      "Generate a 1 second mono tone from the first 32 harmonics of C3 falling at 9dB per octave and save it to 'additive.wav'."},
+    {"gentone --wave fm --ratio 1,3.5 --index 2.5 --feedback 0.7 --output bell.wav C5",
+      "Generate a 1 second mono two-operator fm tone using the musical note C5, with a modulator at 3.5 times the carrier and self-modulation, and save it to 'bell.wav'."},
+    {"gentone --time 10 --wave pink --seed 7 --amplitude 0.5 --output pink.wav",
+      "Generate 10 seconds of mono pink noise at half amplitude from the seed 7 and save it to 'pink.wav'."},
+    {"gentone --wave square --oversample 4 --output square.wav C7",
+      "Generate a 1 second mono square wave using the musical note C7, synthesized at 4 times the sample rate and filtered down to keep aliasing out of the audible band, and save the tone to the output file 'square.wav'."},
+    {"gentone --time 3 --table cycle.wav --output custom.wav A2",
+      "Generate a 3 second mono tone using the musical note A2 from the single cycle waveform in the file 'cycle.wav' and save the tone to the output file 'custom.wav'."},
+    {"gentone --time 60 --wave square --bench 440",
+      "Compare the synthesis throughput and output difference of a 60 second square wave with a frequency of 440Hz."},
+    {"gentone --time 60 --precision table --bench 440",
+      "Compare the throughput, max error, and SNR of each sine precision for a 60 second tone with a frequency of 440Hz."},
+    {"gentone --check",
+      "Check the synthesis kernels of every instruction set the cpu supports against each other, and the naive shapes of a 1 second tone with a frequency of 440Hz against their analytic form."},
+    {"gentone --cpu-info",
+      "Print the detected cpu features and the selected synthesis kernel."},
     {"gentone --help --colour=off",
       "Print the help output, without colour."},
     {"gentone --help",
@@ -119,12 +150,32 @@ inline void program_init(OB::Parg& pg)
   pg.set("char", "*", "char", "The character used to draw the wave diagram.");
   pg.set("a4", "440", "Hz", "The standard pitch frequency used for the A above middle C.");
   pg.set("sos", "343", "m/s", "The speed of sound.");
-  pg.set("wave,w", "sine", "sine|square|triangle|saw", "The type of waveform used to generate the tone.");
-  pg.set("time,t", "0", "seconds", "The duration of the tone in seconds.");
+  pg.set("wave,w", "sine", "sine|square|triangle|saw|additive|fm|white|pink|brown", "The type of waveform used to generate the tone, 'additive' sums a series of harmonics, 'fm' stacks phase-modulated sines, and 'white', 'pink' and 'brown' are noise with a flat spectrum, one falling at 3dB per octave and one at 6dB, which ignore the frequency.");
+  pg.set("harmonics", "16", "1-4096", "The number of harmonics summed by the additive wave, those at or past half the sample rate are left out.");
+  pg.set("rolloff", "1", "exponent", "The amplitude of the k-th harmonic of the additive wave is 1 / k^exponent, 1 falls like a saw at 6dB per octave, 2 at 12dB per octave and 0 keeps them all equal.");
+  pg.set("table", "", "file", "Play a single cycle waveform loaded from the first channel of a WAV file instead of the wave, it is band-limited into one table per octave so any note plays without aliasing.");
+  pg.set("ratio", "1,1", "carrier,modulator,...", "The frequencies of the fm operators as multiples of the tone frequency, the first is the carrier and each one after it modulates the one before it.");
+  pg.set("index", "1", "radians,...", "The modulation index of each fm modulator, its peak deviation of the operator below it in radians, one for every ratio after the carrier.");
+  pg.set("feedback", "0", "radians", "The amount the top fm operator modulates itself by, from a pure sine at 0 towards a saw-like tone around 1.5, and noise past 2. The loop is re-seeded ahead of every 1024 frames so they render on their own, from a period of the top operator before them, which keeps it within 1 LSB of one loop run through the whole tone up to 2, as --check verifies.");
+  pg.set("phase", "fixed", "fixed|float", "The phase accumulator used by the oscillator, 'fixed' is a drift-free 64-bit accumulator, 'float' derives the phase from the frame index in double precision.");
+  pg.set("precision", "exact", "exact|polynomial|table", "The accuracy of the sine, 'exact' follows libm with a max error of 2.5e-13 and a SNR of 257dB, 'polynomial' uses a minimax polynomial with a max error of 4.8e-9 and a SNR of 169dB, 'table' interpolates a 2049 entry table with a max error of 1.2e-6 and a SNR of 121dB.");
+  pg.set("antialias", "none", "none|polyblep", "The treatment of the edges of the triangle, square and saw, 'polyblep' smooths the two frames around each edge into a band-limited step, which removes most of the aliasing at high notes for little cost.");
+  pg.set("oversample", "1", "1|2|4|8", "Synthesize the tone at this multiple of the sample rate and decimate it with a cascade of half-band filters, which keep the band up to 45% of the sample rate and reject what would fold into it by 100dB. Harmonics past half the higher rate still alias, combined with 'polyblep' the edges come out cleanest.");
+  pg.set("time,t", "0", "seconds|inf", "The duration of the tone in seconds, 'inf' plays or writes the tone until interrupted.");
   pg.set("channels,c", "1", "1|2|mono|stereo|left|right", "The number of channels to use, 1 is mono, 2 is stereo.");
   pg.set("rate,r", "44100", "Hz", "The sample rate used to generate the tone.");
+  pg.set("rates", "", "Hz,...", "Also save the tone resampled to each of these sample rates, to WAV files named after the output with the rate appended. The tone is synthesized once at the sample rate and converted by polyphase windowed-sinc filters that keep the band up to 45% of the lower rate and reject aliasing by 100dB.");
   pg.set("amplitude,a", "1", "0.0-1.0", "The max amplitude of the generated tone.");
-  pg.set("output,o", "", "file", "Save the generated tone to a file.");
+  pg.set("output,o", "", "file|-", "Save the generated tone to a file, the format follows the file extension, WAV files are streamed to disk and switch to RF64 past 4GB, '-' writes raw samples to stdout.");
+  pg.set("format", "s16le", "s16le|s24le|s32le|f32le", "The sample format of WAV files and of raw output to stdout, signed 16, 24 or 32-bit integers or 32-bit float, little endian and interleaved. 16-bit samples are truncated, 24 and 32-bit samples are rounded.");
+  pg.set("dither", "none", "none|tpdf", "Add triangular dither of one step to the integer samples before rounding them, so quantization leaves noise instead of harmonic distortion, each channel gets its own noise.");
+  pg.set("seed", "0", "N", "The 32-bit seed of the noise waves and the dither, the same seed renders the same noise on any number of jobs.");
+  pg.set("shaping", "none", "none|first|lipshitz", "Shape the quantization noise of the integer samples by feeding the rounding error back, 'first' pushes it up at 6dB per octave, 'lipshitz' moves it out of the most audible bands and is tuned for 44.1kHz. Shaping runs a feedback loop per sample and renders about a third as fast as unshaped dither.");
+  pg.set("jobs,j", "1", "N", "The number of threads used to render the tone, 0 uses every hardware thread, the output is identical for any value.");
+  pg.set("kernel", "auto", "auto|scalar|sse2|avx2|avx512", "The instruction set used by the synthesis kernels, 'auto' selects the widest one supported by the cpu.");
+  pg.set("cpu-info", "Print the detected cpu features and the selected synthesis kernel.");
+  pg.set("bench", "Measure the synthesis throughput of the oscillator against the reference libm implementation, and check its output against the analytic waveform.");
+  pg.set("check", "Check that every synthesis kernel the cpu supports gives the same output as the scalar one wherever it promises to, and that the triangle, square and saw of the tone are within 1 LSB of their analytic form with no frame on the wrong side of an edge on every kernel and phase, and exit with 1 on any failure.");
 
   // allow and capture positional arguments
   pg.set_pos();
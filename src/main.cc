@@ -48,23 +48,37 @@ SOFTWARE.
 #include "ob/term.hh"
 #include "ob/prism.hh"
 #include "ob/string.hh"
+#include "ob/ring.hh"
+#include "ob/buffer.hh"
+#include "ob/pcm.hh"
+#include "ob/wav.hh"
+#include "ob/dither.hh"
+#include "ob/tone.hh"
+#include "ob/kernel.hh"
 
 #include <SFML/Audio.hpp>
 
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
 #include <cstdlib>
 #include <cassert>
 #include <csignal>
 
+#include <atomic>
 #include <chrono>
 #include <thread>
 #include <limits>
+#include <numeric>
+#include <memory>
 #include <string>
 #include <vector>
+#include <utility>
+#include <algorithm>
 #include <sstream>
 #include <iomanip>
 #include <iostream>
+#include <functional>
 #include <type_traits>
 
 // #define dbg(x) std::cerr << "DBG> "#x": " << (x) << "\n"
@@ -78,6 +92,11 @@ bool is_term {false};
 bool use_color {false};
 std::size_t cursor_y {0};
 
+// while a file is written an interrupt ends the render loop instead of the
+// program, so the file is closed with the frames written so far
+std::atomic<bool> writing {false};
+std::atomic<bool> interrupted {false};
+
 std::vector<std::string> const channel_str {
   "unknown",
   "mono",
@@ -95,18 +114,40 @@ struct Channel {
   };
 };
 
-struct Track {
-  sf::SoundBuffer buf;
-  sf::Sound sound;
-};
+// Streams a tone source to the audio device, a synthesis thread renders
+// blocks ahead of playback into a lock-free ring that the audio thread drains,
+// so playback starts after the first block and memory does not depend on the
+// length of the tone.
+// Given a loop of 'loop' frames, the first frames of the source are instead
+// played over and over, with the seam crossfaded over 'fade' frames.
+class Track : public sf::SoundStream {
+public:
+  Track(OB::Tone::Source<short> const& source, int const sample_rate, std::size_t const loop = 0, std::size_t const fade = 0);
+  ~Track();
+
+  // number of times the audio thread found the ring empty after playback started
+  std::size_t underruns() const {
+    return _underruns.load(std::memory_order_relaxed);
+  }
+
+private:
+  bool onGetData(Chunk& data) override;
+  void onSeek(sf::Time offset) override;
+  void produce();
 
-struct Wave {
-  int num_channels {0};
-  int sample_rate {0};
-  int num_samples {0};
-  std::vector<short> samples;
+  OB::Tone::Source<short> _source;
+  bool const _loop;
+  OB::Ring<short> _ring;
+  std::vector<short> _chunk;
+  bool _primed {false};
+  std::atomic<bool> _done {false};
+  std::atomic<bool> _quit {false};
+  std::atomic<std::size_t> _underruns {0};
+  std::thread _thread;
 };
 
+using Wave = OB::Buffer<short>;
+
 struct Data {
   std::string graphic;
   double a4 {0};
@@ -115,11 +156,31 @@ struct Data {
   double freq {0};
   double size {0};
   std::string wave;
+  std::string table;
+  std::shared_ptr<OB::Tone::Wavetable const> wavetable;
+  std::string phase;
+  std::string precision;
+  std::string antialias;
+  std::size_t oversample {1};
+  std::size_t harmonics {0};
+  double rolloff {0};
+  std::string ratio;
+  std::string index;
+  std::vector<double> ratios;
+  std::vector<double> indexes;
+  double feedback {0};
+  std::string format;
+  std::string dither;
+  std::uint32_t seed {0};
+  std::string shaping;
   int rate {0};
+  std::string rates;
+  std::vector<int> extra_rates;
   double ampl {0};
   int chan {0};
   double time {0};
   bool loop {false};
+  std::size_t jobs {1};
 };
 
 template <typename T = std::chrono::milliseconds>
@@ -146,15 +207,35 @@ std::string term_bg(OB::Prism::RGBA rgba);
 void smooth_samples(Wave& wave);
 std::string freq_to_note(double const freq, double const a4 = 440.0);
 double note_to_freq(std::string const& note, double const a4 = 440.0);
-Wave make_wave(Data const& data);
-Track make_track(Wave const& wave, bool const loop);
+std::size_t tone_size(Data const& data, int const rate);
+std::size_t tone_size(Data const& data);
+bool is_noise(std::string const& wave);
+std::size_t tone_period(Data const& data, int const rate, std::size_t const limit);
+OB::Tone::Loop tone_loop(Data const& data, std::size_t const limit, double const tolerance);
+OB::Tone::Generator make_generator(Data const& data);
+Wave make_wave(Data const& data, std::size_t const size);
+std::size_t draw_size(Data const& data);
+std::pair<int, std::size_t> analytic_diff(Data const& data, OB::Tone::Shape const shape, OB::Tone::Phase const phase, std::vector<double> const& osc);
+void bench_wave(Data const& data);
+std::vector<std::string> check_kernels(OB::Kernel::Isa const isa);
+void check(Data const& data);
 bool is_playing(Track const& track);
 void draw_wave(Wave const& wave, Data const& data, Track const* track = nullptr);
-void save_to_file(Wave const& wave, std::string const& output);
+std::string rate_path(std::string const& output, int const rate);
+std::size_t rate_frame(std::size_t const frame, int const from, int const to);
+void save_to_file(Data const& data, std::string const& output);
+void save_to_stdout(Data const& data);
 Data make_data(Parg& pg);
 void print_data(Data const& data);
+void print_cpu_info();
+void print_track(Track const& track);
 
 void signal_handler(int signal) {
+  // a second interrupt exits without waiting for the file
+  if (writing && !interrupted) {
+    interrupted = true;
+    return;
+  }
   std::cout << aec::clear;
   if (cursor_y > 0) {
     std::cout << aec::cursor_set(1, cursor_y);
@@ -188,11 +269,10 @@ std::string term_bg(OB::Prism::RGBA rgba) {
 }
 
 void smooth_samples(Wave& wave) {
-  for (auto it = wave.samples.rbegin(); it != wave.samples.rend(); ++it) {
-    if (*it <= 0) {
-      auto dist = std::distance(wave.samples.rbegin(), std::prev(it));
-      wave.num_samples -= dist;
-      wave.samples.erase(it.base(), std::rbegin(wave.samples).base());
+  // drop the frames after the last one that is not above zero
+  for (std::size_t frame = wave.frames(); frame > 0; --frame) {
+    if (wave.at(frame - 1, 0) <= 0) {
+      wave.resize(frame);
       break;
     }
   }
@@ -210,8 +290,9 @@ std::string freq_to_note(double const freq, double const a4) {
     {11, "B"},
   };
   int const semitones {static_cast<int>(std::round(std::log(freq / a4) / std::log(std::pow(2.0, 1.0 / 12.0))) + 57)};
-  std::size_t const offset {static_cast<std::size_t>(semitones % 12)};
-  int const octave {semitones / 12};
+  // notes below C0 fall in negative octaves
+  int const octave {semitones >= 0 ? semitones / 12 : -((11 - semitones) / 12)};
+  std::size_t const offset {static_cast<std::size_t>(semitones - 12 * octave)};
   return c_offset.at(offset) + std::to_string(octave);
 }
 
@@ -233,93 +314,617 @@ double note_to_freq(std::string const& note, double const a4) {
   return 0.01 * std::round((a4 * std::pow(std::pow(2.0, 1.0/12.0), semitones)) * 100.0);
 }
 
-Wave make_wave(Data const& data) {
-  Wave wave {data.chan > 2 ? 2 : data.chan, data.rate, 0, std::vector<short>()};
-  int const bits {16};
-  bool const sign {true};
-  double const max_amplitude {(std::pow(2, (sign ? bits - 1 : bits))) - 1};
-  std::size_t const size {static_cast<std::size_t>((data.time < 1 ? 1 : data.time) * wave.sample_rate)};
-  wave.num_samples += static_cast<int>(size) * wave.num_channels;
-  wave.samples.reserve(static_cast<std::size_t>(wave.num_samples));
+template<typename F>
+void run_jobs(std::size_t const jobs, std::size_t const size, std::size_t const align, F const& fn) {
+  // split [0, size) into contiguous ranges on 'align' boundaries, one per thread
+  std::size_t const step {((size / align + jobs - 1) / jobs) * align};
+  if (jobs < 2 || step >= size) {
+    fn(std::size_t {0}, size);
+    return;
+  }
+  std::vector<std::thread> threads;
+  for (std::size_t begin = step; begin < size; begin += step) {
+    threads.emplace_back(fn, begin, std::min(size, begin + step));
+  }
+  fn(std::size_t {0}, step);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+std::size_t tone_size(Data const& data, int const rate) {
+  // an infinite tone never runs out of frames
+  if (std::isinf(data.time)) {return std::numeric_limits<std::size_t>::max();}
+  return static_cast<std::size_t>((data.time < 1 ? 1 : data.time) * rate);
+}
 
-  if (data.wave == "sine") {
-    for (std::size_t i = 0; i < size; ++i) {
-      for (std::size_t j = 0; j < static_cast<std::size_t>(wave.num_channels); ++j) {
-        if (((data.chan == Channel::Right) && (j == 0)) || ((data.chan == Channel::Left) && (j == 1))) {
-          wave.samples.emplace_back(0);
-        }
-        else {
-          auto const sample {data.ampl * max_amplitude * std::sin((2.0 * M_PI * (data.freq / wave.sample_rate * i)))};
-          wave.samples.emplace_back(sample);
-        }
+std::size_t tone_size(Data const& data) {
+  return tone_size(data, data.rate);
+}
+
+bool is_noise(std::string const& wave) {
+  return wave == "white" || wave == "pink" || wave == "brown";
+}
+
+// an fm stack repeats once every operator has come around, noise never does
+std::size_t tone_period(Data const& data, int const rate, std::size_t const limit) {
+  if (is_noise(data.wave) && !data.wavetable) {return 0;}
+  std::size_t res {OB::Tone::period(data.freq, rate, limit)};
+  if (data.wave != "fm" || data.wavetable) {return res;}
+  for (auto const ratio : data.ratios) {
+    std::size_t const period {OB::Tone::period(data.freq * ratio, rate, limit)};
+    if (!res || !period) {return 0;}
+    res = std::lcm(res, period);
+    if (res > limit) {return 0;}
+  }
+  return res;
+}
+
+// loop of whole cycles of the slowest frequency every fm operator comes
+// around at, the gcd of the ratios read as fractions over 1000, its seam jumps
+// as many times further as the fastest operator turns within one cycle, and
+// no loop fits when a ratio is not such a fraction
+OB::Tone::Loop tone_loop(Data const& data, std::size_t const limit, double const tolerance) {
+  if (data.wave != "fm" || data.wavetable) {return OB::Tone::loop(data.freq, data.rate, limit, tolerance);}
+  std::uint64_t common {0};
+  std::uint64_t top {0};
+  for (auto const ratio : data.ratios) {
+    double const num {std::round(ratio * 1000.0)};
+    if (num < 1 || num > 0x1p53 || std::fabs(num - ratio * 1000.0) > 1e-9 * num) {return {};}
+    common = std::gcd(common, static_cast<std::uint64_t>(num));
+    top = std::max(top, static_cast<std::uint64_t>(num));
+  }
+  double const turns {static_cast<double>(top / common)};
+  auto res {OB::Tone::loop(data.freq * static_cast<double>(common) / 1000.0, data.rate, limit, tolerance / turns)};
+  res.error *= turns;
+  return res;
+}
+
+OB::Tone::Generator make_generator(Data const& data) {
+  if (data.wavetable) {
+    OB::Tone::Lookup const gen {data.wavetable, data.freq, data.rate, OB::Tone::to_phase(data.phase)};
+    return [gen](double* out, std::size_t const size, std::size_t const start) {gen.render(out, size, start);};
+  }
+  if (data.wave == "additive") {
+    OB::Tone::Additive const gen {data.harmonics, data.rolloff, data.freq, data.rate, OB::Tone::to_phase(data.phase), data.oversample};
+    return [gen](double* out, std::size_t const size, std::size_t const start) {gen.render(out, size, start);};
+  }
+  if (is_noise(data.wave)) {
+    OB::Tone::Noise const gen {OB::Tone::to_color(data.wave), data.seed};
+    return [gen](double* out, std::size_t const size, std::size_t const start) {gen.render(out, size, start);};
+  }
+  if (data.wave == "fm") {
+    OB::Tone::Fm const gen {data.ratios, data.indexes, data.feedback, data.freq, data.rate, OB::Tone::to_phase(data.phase), data.oversample};
+    return [gen](double* out, std::size_t const size, std::size_t const start) {gen.render(out, size, start);};
+  }
+  OB::Tone::Oscillator const gen {OB::Tone::to_shape(data.wave), data.freq, data.rate, OB::Tone::to_phase(data.phase), OB::Tone::to_precision(data.precision), OB::Tone::to_antialias(data.antialias), data.oversample};
+  return [gen](double* out, std::size_t const size, std::size_t const start) {gen.render(out, size, start);};
+}
+
+// sources render for the sample format, 24-bit samples are held in 32 bits,
+// the generator runs at 'rate'
+template<typename T>
+OB::Tone::Source<T> make_source(Data const& data, OB::Tone::Generator const& gen, int const rate, std::size_t const size, OB::Pcm::Format const format) {
+  OB::Tone::Layout layout;
+  if (data.chan != Channel::Mono) {
+    layout.channels = 2;
+    layout.left = data.chan != Channel::Right;
+    layout.right = data.chan != Channel::Left;
+  }
+
+  // a tone with a rational period repeats exactly, only the first period is
+  // synthesized and the rest is copied from it
+  std::size_t const period {tone_period(data, rate, std::min(size / 2, OB::Tone::Source<T>::tile))};
+
+  // floats have no steps to dither
+  OB::Dither::Quantizer quant;
+  if (format != OB::Pcm::Format::F32) {
+    quant = OB::Dither::Quantizer(OB::Dither::to_type(data.dither), OB::Dither::to_shaping(data.shaping), OB::Pcm::full_scale(format), data.seed);
+  }
+
+  return OB::Tone::Source<T>(gen, data.ampl * OB::Pcm::full_scale(format), size, layout, period, quant);
+}
+
+template<typename T>
+OB::Tone::Source<T> make_source(Data const& data, std::size_t const size, OB::Pcm::Format const format = OB::Pcm::Format::S16) {
+  return make_source<T>(data, make_generator(data), data.rate, size, format);
+}
+
+template<typename T>
+void render_source(OB::Tone::Source<T> const& source, T* out, std::size_t const start, std::size_t const size, std::size_t const jobs) {
+  // the oscillator output is a pure function of the frame index, so ranges
+  // aligned to its renorm grid render the same samples on any thread
+  run_jobs(jobs, size, OB::Tone::Oscillator::renorm, [&](std::size_t const begin, std::size_t const end) {
+    source.render(out + begin * source.channels(), end - begin, start + begin);
+  });
+}
+
+Wave make_wave(Data const& data, std::size_t const size) {
+  auto const source {make_source<short>(data, size)};
+  Wave wave {source.channels(), data.rate, size};
+  render_source(source, wave.data(), 0, size, data.jobs);
+  return wave;
+}
+
+// best of three times to render and encode 'size' frames in a sample format,
+// a stretch at a time the way files are written
+template<typename T>
+double time_format(Data const& data, std::size_t const size, OB::Pcm::Format const format) {
+  auto const source {make_source<T>(data, size, format)};
+  std::size_t const stretch {OB::Tone::Source<T>::block * 64 * data.jobs};
+  std::vector<T> buf (stretch * source.channels());
+  double t {std::numeric_limits<double>::max()};
+  for (std::size_t run = 0; run < 3; ++run) {
+    auto const start {std::chrono::steady_clock::now()};
+    for (std::size_t pos = 0; pos < size; pos += stretch) {
+      std::size_t const len {std::min(stretch, size - pos)};
+      render_source(source, buf.data(), pos, len, data.jobs);
+      OB::Pcm::encode(format, buf.data(), len * source.channels());
+    }
+    t = std::min(t, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+  }
+  return t;
+}
+
+// compares a shape to the analytic one after 16-bit truncation, at the phase
+// the phase mode derives, from the accumulator or from the frame index in
+// double precision, and returns the largest difference in LSB and the frames
+// past 1 LSB, which the kernel has put on the wrong side of an edge
+std::pair<int, std::size_t> analytic_diff(Data const& data, OB::Tone::Shape const shape, OB::Tone::Phase const phase, std::vector<double> const& osc) {
+  double const max_amplitude {data.ampl * std::numeric_limits<short>::max()};
+  OB::Tone::Accumulator const acc {data.freq, static_cast<double>(data.rate)};
+  double const inc {data.freq / data.rate - std::floor(data.freq / data.rate)};
+  int max_diff {0};
+  std::size_t flips {0};
+  for (std::size_t i = 0; i < osc.size(); ++i) {
+    // the fixed phase is rounded towards zero, so one short of an edge does
+    // not round onto it
+    double const cycle {phase == OB::Tone::Phase::Fixed ?
+      OB::Tone::Accumulator::cycles(acc.at(i) & ~std::uint64_t {0x7ff}) :
+      inc * static_cast<double>(i) - std::floor(inc * static_cast<double>(i))};
+    int const diff {std::abs(static_cast<short>(max_amplitude * OB::Tone::analytic(shape, cycle)) - static_cast<short>(max_amplitude * osc[i]))};
+    if (diff > 1) {
+      ++flips;
+    }
+    else {
+      max_diff = std::max(max_diff, diff);
+    }
+  }
+  return {max_diff, flips};
+}
+
+void bench_wave(Data const& data) {
+  struct Style {
+    std::string punc {aec::fg_true("c0c0c0")};
+    std::string key {aec::fg_true("ff54ff")};
+    std::string value {aec::fg_true("54ff54")};
+    std::string unit {aec::fg_true("c0c0c0")};
+  };
+  Style style;
+
+  auto const print_kv = [&](auto const& key, auto const& value) {
+    std::cout << aec::wrap(key, style.key, use_color) << aec::wrap(": ", style.punc, use_color) << aec::wrap(value, style.value, use_color) << "\n";
+  };
+
+  auto const print_kvu = [&](auto const& key, auto const& value, auto const& unit) {
+    std::cout << aec::wrap(key, style.key, use_color) << aec::wrap(": ", style.punc, use_color) << aec::wrap(value, style.value, use_color) << " " << aec::wrap(unit, style.unit, use_color) << "\n";
+  };
+
+  auto const time_it = [](auto const& fn) {
+    auto const start {std::chrono::steady_clock::now()};
+    fn();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  };
+
+  if (std::isinf(data.time)) {throw std::runtime_error("invalid time 'inf' for bench");}
+  if (data.wavetable) {throw std::runtime_error("invalid table '" + data.table + "' for bench");}
+  if (data.wave == "additive" || data.wave == "fm" || is_noise(data.wave)) {throw std::runtime_error("invalid wave '" + data.wave + "' for bench, it has no analytic form");}
+  auto const shape {OB::Tone::to_shape(data.wave)};
+  std::size_t const size {tone_size(data)};
+  std::vector<double> ref (size);
+  std::vector<double> osc (size);
+
+  auto const t_ref {time_it([&]() {
+    OB::Tone::reference(shape, data.freq, data.rate, ref.data(), size, 0);
+  })};
+  auto const t_osc {time_it([&]() {
+    OB::Tone::Oscillator(shape, data.freq, data.rate, OB::Tone::to_phase(data.phase), OB::Tone::to_precision(data.precision), OB::Tone::to_antialias(data.antialias), data.oversample).render(osc.data(), size, 0);
+  })};
+
+  auto const [max_diff, flips] = analytic_diff(data, shape, OB::Tone::to_phase(data.phase), osc);
+
+  std::cout << "\n";
+  print_kv(" kern", OB::Kernel::to_string(OB::Kernel::active().isa));
+  print_kvu(" libm", OB::String::to_string(size / t_ref / 1e6), "Mframes/s");
+  print_kvu("  osc", OB::String::to_string(size / t_osc / 1e6), "Mframes/s");
+  print_kvu(" gain", OB::String::to_string(t_ref / t_osc), "x");
+  print_kvu(" diff", max_diff, "LSB");
+  print_kvu(" flip", flips, "frames");
+  print_kvu(" tile", OB::Tone::period(data.freq, data.rate, size / 2), "frames");
+
+  // best of three throughput of the whole make_wave pipeline for every waveform and channel layout
+  auto const pad = [](std::string const& str, std::size_t const width) {
+    return std::string(str.size() < width ? width - str.size() : 0, ' ') + str;
+  };
+  std::cout << "\n" << std::string(8, ' ');
+  for (std::size_t chan = Channel::Mono; chan <= Channel::Right; ++chan) {
+    std::cout << aec::wrap(pad(channel_str.at(chan), 8), style.key, use_color);
+  }
+  std::cout << aec::wrap("  Mframes/s", style.unit, use_color) << "\n";
+  for (auto const& wave : {"sine", "triangle", "square", "saw", "additive", "fm", "white", "pink", "brown"}) {
+    std::cout << aec::wrap(pad(wave, 8), style.key, use_color);
+    for (int chan = Channel::Mono; chan <= Channel::Right; ++chan) {
+      Data tmp {data};
+      tmp.wave = wave;
+      tmp.chan = chan;
+      double t {std::numeric_limits<double>::max()};
+      for (std::size_t run = 0; run < 3; ++run) {
+        t = std::min(t, time_it([&]() {make_wave(tmp, size);}));
       }
+      std::cout << aec::wrap(pad(OB::String::to_string(size / t / 1e6), 8), style.value, use_color);
     }
+    std::cout << "\n";
+  }
+
+  // throughput and accuracy of every sine precision against the long double
+  // sine at the exact phase, the snr is relative to a full-scale sine
+  auto const fmt = [](double const val, bool const sci) {
+    std::ostringstream ss;
+    ss << (sci ? std::scientific : std::fixed) << std::setprecision(1) << val;
+    return ss.str();
+  };
+  long double const inc {static_cast<long double>(data.freq) / data.rate};
+  std::vector<double> exact (size);
+  for (std::size_t i = 0; i < size; ++i) {
+    exact[i] = static_cast<double>(std::sin(2.0L * static_cast<long double>(M_PI) * std::fmod(inc * i, 1.0L)));
   }
-  else if (data.wave == "triangle") {
+  std::cout << "\n" << std::string(10, ' ');
+  for (auto const& col : {"Mframes/s", "max err", "snr dB"}) {
+    std::cout << aec::wrap(pad(col, 10), style.key, use_color);
+  }
+  std::cout << "\n";
+  for (auto const& precision : {"exact", "polynomial", "table"}) {
+    OB::Tone::Oscillator const sine {OB::Tone::Shape::Sine, data.freq, data.rate, OB::Tone::to_phase(data.phase), OB::Tone::to_precision(precision)};
+    double t {std::numeric_limits<double>::max()};
+    for (std::size_t run = 0; run < 3; ++run) {
+      t = std::min(t, time_it([&]() {sine.render(osc.data(), size, 0);}));
+    }
+    double max_err {0};
+    long double noise {0};
     for (std::size_t i = 0; i < size; ++i) {
-      for (std::size_t j = 0; j < static_cast<std::size_t>(wave.num_channels); ++j) {
-        if (((data.chan == Channel::Right) && (j == 0)) || ((data.chan == Channel::Left) && (j == 1))) {
-          wave.samples.emplace_back(0);
-        }
-        else {
-          wave.samples.emplace_back(((2 * (data.ampl * max_amplitude)) / M_PI) * std::asin(std::sin((2 * M_PI * (data.freq / wave.sample_rate)) * i)));
-        }
+      double const err {osc[i] - exact[i]};
+      max_err = std::max(max_err, std::fabs(err));
+      noise += static_cast<long double>(err) * err;
+    }
+    double const snr {static_cast<double>(10.0L * std::log10(0.5L * size / noise))};
+    std::cout << aec::wrap(pad(precision, 10), style.key, use_color);
+    std::cout << aec::wrap(pad(OB::String::to_string(size / t / 1e6), 10), style.value, use_color);
+    std::cout << aec::wrap(pad(fmt(max_err, true), 10), style.value, use_color);
+    std::cout << aec::wrap(pad(fmt(snr, false), 10), style.value, use_color) << "\n";
+  }
+
+  // throughput of rendering and encoding every sample format, plain and
+  // dithered, floats are never dithered
+  std::cout << "\n" << std::string(10, ' ');
+  for (auto const& col : {"plain", "tpdf", "lipshitz"}) {
+    std::cout << aec::wrap(pad(col, 10), style.key, use_color);
+  }
+  std::cout << aec::wrap("  Mframes/s", style.unit, use_color) << "\n";
+  for (auto const format : {OB::Pcm::Format::S16, OB::Pcm::Format::S24, OB::Pcm::Format::S32, OB::Pcm::Format::F32}) {
+    std::cout << aec::wrap(pad(OB::Pcm::to_string(format), 10), style.key, use_color);
+    for (auto const& [dither, shaping] : {std::pair {"none", "none"}, std::pair {"tpdf", "none"}, std::pair {"tpdf", "lipshitz"}}) {
+      Data tmp {data};
+      tmp.dither = dither;
+      tmp.shaping = shaping;
+      double t {0};
+      switch (format) {
+        case OB::Pcm::Format::S24:
+        case OB::Pcm::Format::S32: t = time_format<std::int32_t>(tmp, size, format); break;
+        case OB::Pcm::Format::F32: t = time_format<float>(tmp, size, format); break;
+        default: t = time_format<short>(tmp, size, format); break;
       }
+      std::cout << aec::wrap(pad(OB::String::to_string(size / t / 1e6), 10), style.value, use_color);
     }
+    std::cout << "\n";
   }
-  else if (data.wave == "square") {
-    for (std::size_t i = 0; i < size; ++i) {
-      for (std::size_t j = 0; j < static_cast<std::size_t>(wave.num_channels); ++j) {
-        if (((data.chan == Channel::Right) && (j == 0)) || ((data.chan == Channel::Left) && (j == 1))) {
-          wave.samples.emplace_back(0);
-        }
-        else {
-          auto sample {std::sin((2.0 * M_PI * (data.freq / wave.sample_rate * i)))};
-          if (sample >= 0) {
-            sample = data.ampl * (max_amplitude - 1);
-          }
-          else if (sample < 0) {
-            sample = data.ampl * -max_amplitude;
-          }
-          wave.samples.emplace_back(sample);
+}
+
+// runs every kernel that promises the same output on every instruction set
+// over the same input, and returns the names of those whose output differs
+// bit for bit from the scalar kernel
+std::vector<std::string> check_kernels(OB::Kernel::Isa const isa) {
+  using Table = OB::Kernel::Table;
+  std::size_t const size {1027};
+
+  // a fixed sequence of fractions in [-1, 1) feeds every input
+  std::uint64_t state {0x9e3779b97f4a7c15ull};
+  auto const next = [&]() {
+    state = state * 6364136223846793005ull + 1442695040888963407ull;
+    return static_cast<double>(static_cast<std::int64_t>(state)) * 0x1p-63;
+  };
+  auto const fill = [&](std::size_t const count) {
+    std::vector<double> res (count);
+    for (auto& val : res) {val = next();}
+    return res;
+  };
+  auto const bits = [&](auto* out, std::size_t const count) {
+    for (std::size_t i = 0; i < count; ++i) {
+      state = state * 6364136223846793005ull + 1442695040888963407ull;
+      out[i] = static_cast<std::remove_pointer_t<decltype(out)>>(state >> 11);
+    }
+  };
+  auto const bytes = [](auto const& vec) {
+    return std::string(reinterpret_cast<char const*>(vec.data()), vec.size() * sizeof(vec[0]));
+  };
+
+  auto const in {fill(size)};
+  auto const dither {fill(size)};
+  std::vector<double> sine (size);
+  std::vector<double> cosine (size);
+  for (std::size_t i = 0; i < size; ++i) {
+    double const x {M_PI * next()};
+    sine[i] = std::sin(x);
+    cosine[i] = std::cos(x);
+  }
+  std::vector<double> amps (24);
+  for (std::size_t k = 0; k < amps.size(); ++k) {amps[k] = 1.0 / static_cast<double>(k + 1);}
+  // the lipshitz filter, at a gain that clips some steps and errors
+  std::vector<double> const coefs {2.033, -2.165, 1.959, -1.590, 0.6149};
+  std::size_t const count {12};
+  auto const taps {fill(count)};
+  auto const even {fill(size + count)};
+  auto const odd {fill(size + count)};
+  std::size_t const width {16};
+  std::size_t const up {160};
+  std::size_t const down {147};
+  auto const bank {fill(up * width)};
+  auto const wide {fill(size * down / up + 2 * width)};
+  std::vector<std::uint32_t> keys (OB::Tone::Noise::rows);
+  bits(keys.data(), keys.size());
+  std::vector<double> weights (keys.size());
+  for (std::size_t k = 0; k < weights.size(); ++k) {weights[k] = std::sqrt(std::ldexp(1.0, static_cast<int>(k))) / 512.0;}
+  auto const coarse {fill(size / 4 + 3)};
+  std::vector<short> shorts (size);
+  std::vector<std::int32_t> ints (size);
+  std::vector<std::uint16_t> words (2 * size);
+  std::vector<std::uint32_t> dwords (2 * size);
+  std::vector<std::uint64_t> qwords (2 * size);
+  bits(shorts.data(), shorts.size());
+  bits(ints.data(), ints.size());
+  bits(words.data(), words.size());
+  bits(dwords.data(), dwords.size());
+  bits(qwords.data(), qwords.size());
+  std::uint64_t const phase {0x0123456789abcdefull};
+  std::uint64_t const step {0x00a3d70a3d70a3d7ull};
+
+  std::vector<std::pair<std::string, std::function<std::string(Table const&)>>> const runs {
+    {"triangle", [&](Table const& k) {std::vector<double> out (size); k.triangle(out.data(), size, phase, step); return bytes(out);}},
+    {"square", [&](Table const& k) {std::vector<double> out (size); k.square(out.data(), size, phase, step); return bytes(out);}},
+    {"saw", [&](Table const& k) {std::vector<double> out (size); k.saw(out.data(), size, phase, step); return bytes(out);}},
+    {"partials", [&](Table const& k) {std::vector<double> out (size); k.partials(out.data(), size, sine.data(), cosine.data(), amps.data(), amps.size()); return bytes(out);}},
+    {"quantize", [&](Table const& k) {std::vector<short> out (size); k.quantize(out.data(), in.data(), size, 32767.0); return bytes(out);}},
+    {"spread", [&](Table const& k) {std::vector<short> out (2 * size); k.spread(out.data(), shorts.data(), size, 0xffff, 0); return bytes(out);}},
+    {"round32", [&](Table const& k) {std::vector<std::int32_t> out (size); k.round32(out.data(), in.data(), size, 8388607.0); return bytes(out);}},
+    {"narrow", [&](Table const& k) {std::vector<float> out (size); k.narrow(out.data(), in.data(), size, 0.75); return bytes(out);}},
+    {"spread32", [&](Table const& k) {std::vector<std::uint32_t> out (2 * size); k.spread32(out.data(), dwords.data(), size, 0, 0xffffffffu); return bytes(out);}},
+    {"pack24", [&](Table const& k) {std::vector<std::uint8_t> out (4 * size); k.pack24(out.data(), ints.data(), size); out.resize(3 * size); return bytes(out);}},
+    {"interleave16", [&](Table const& k) {std::vector<std::uint16_t> out (2 * size); k.interleave16(out.data(), words.data(), words.data() + size, size); return bytes(out);}},
+    {"interleave32", [&](Table const& k) {std::vector<std::uint32_t> out (2 * size); k.interleave32(out.data(), dwords.data(), dwords.data() + size, size); return bytes(out);}},
+    {"interleave64", [&](Table const& k) {std::vector<std::uint64_t> out (2 * size); k.interleave64(out.data(), qwords.data(), qwords.data() + size, size); return bytes(out);}},
+    {"deinterleave16", [&](Table const& k) {std::vector<std::uint16_t> out (2 * size); k.deinterleave16(out.data(), out.data() + size, words.data(), size); return bytes(out);}},
+    {"deinterleave32", [&](Table const& k) {std::vector<std::uint32_t> out (2 * size); k.deinterleave32(out.data(), out.data() + size, dwords.data(), size); return bytes(out);}},
+    {"deinterleave64", [&](Table const& k) {std::vector<std::uint64_t> out (2 * size); k.deinterleave64(out.data(), out.data() + size, qwords.data(), size); return bytes(out);}},
+    {"tpdf", [&](Table const& k) {std::vector<double> out (size); k.tpdf(out.data(), size, keys[0], 0xfffffe00u); return bytes(out);}},
+    {"noise", [&](Table const& k) {std::vector<double> out (size); k.noise(out.data(), size, keys.data(), weights.data(), keys.size(), 0x7fffff00u, false); return bytes(out);}},
+    {"noise ramp", [&](Table const& k) {std::vector<double> out (size); k.noise(out.data(), size, keys.data(), weights.data(), keys.size(), 0x7fffff00u, true); return bytes(out);}},
+    {"expand", [&](Table const& k) {std::vector<double> out {in}; k.expand(out.data(), size, coarse.data(), 3, false); return bytes(out);}},
+    {"expand ramp", [&](Table const& k) {std::vector<double> out {in}; k.expand(out.data(), size, coarse.data(), 3, true); return bytes(out);}},
+    {"requantize", [&](Table const& k) {std::vector<double> out (size); k.requantize(out.data(), in.data(), dither.data(), size, 32767.0, -32768.0, 32767.0); return bytes(out);}},
+    {"shape", [&](Table const& k) {std::vector<double> out (size); k.shape(out.data(), in.data(), dither.data(), 280, 240, 24, coefs.data(), 40000.0, -32768.0, 32767.0, 2.0); return bytes(out);}},
+    {"halfband", [&](Table const& k) {std::vector<double> out (size); k.halfband(out.data(), even.data(), odd.data(), size, taps.data(), count); return bytes(out);}},
+    {"polyphase", [&](Table const& k) {std::vector<double> out (size); k.polyphase(out.data(), size, wide.data(), bank.data(), width, up, down, 7); return bytes(out);}},
+  };
+
+  // the tables are switched through the global selection, which is put back
+  auto const prev {OB::Kernel::active().isa};
+  std::vector<std::string> expect;
+  OB::Kernel::select(OB::Kernel::Isa::Scalar);
+  for (auto const& [name, run] : runs) {
+    expect.emplace_back(run(OB::Kernel::active()));
+  }
+  std::vector<std::string> res;
+  OB::Kernel::select(isa);
+  for (std::size_t i = 0; i < runs.size(); ++i) {
+    if (runs[i].second(OB::Kernel::active()) != expect[i]) {
+      res.emplace_back(runs[i].first);
+    }
+  }
+  OB::Kernel::select(prev);
+  return res;
+}
+
+void check(Data const& data) {
+  struct Style {
+    std::string punc {aec::fg_true("c0c0c0")};
+    std::string key {aec::fg_true("ff54ff")};
+    std::string value {aec::fg_true("54ff54")};
+    std::string error {aec::fg_true("ff5454")};
+  };
+  Style style;
+
+  bool pass {true};
+  auto const print_kv = [&](auto const& key, std::string const& value, bool const ok) {
+    std::cout << aec::wrap(key, style.key, use_color) << aec::wrap(": ", style.punc, use_color) << aec::wrap(value, ok ? style.value : style.error, use_color) << "\n";
+    pass = pass && ok;
+  };
+  auto const pad = [](std::string const& key) {
+    return std::string(key.size() < 14 ? 14 - key.size() : 0, ' ') + key;
+  };
+
+  // kernels that agree with the scalar one on every instruction set the cpu has
+  std::cout << "\n";
+  for (auto const isa : {OB::Kernel::Isa::Sse2, OB::Kernel::Isa::Avx2, OB::Kernel::Isa::Avx512}) {
+    if (!OB::Kernel::supported(isa)) {
+      print_kv(pad(OB::Kernel::to_string(isa)), "unsupported", true);
+      continue;
+    }
+    std::string diff;
+    for (auto const& kernel : check_kernels(isa)) {
+      diff += (diff.empty() ? "" : ", ") + kernel;
+    }
+    print_kv(pad(OB::Kernel::to_string(isa)), diff.empty() ? "same" : diff + " differ", diff.empty());
+  }
+
+  // the naive shapes of the tone on every kernel the cpu has are within 1 LSB
+  // of their analytic form after 16-bit truncation, with no frame on the
+  // other side of a discontinuity
+  if (std::isinf(data.time)) {throw std::runtime_error("invalid time 'inf' for check");}
+  std::vector<double> osc (tone_size(data));
+  auto const prev {OB::Kernel::active().isa};
+  std::cout << "\n";
+  for (auto const shape : {"triangle", "square", "saw"}) {
+    for (auto const phase : {"fixed", "float"}) {
+      int max_diff {0};
+      std::size_t flips {0};
+      std::string fail;
+      for (auto const isa : {OB::Kernel::Isa::Scalar, OB::Kernel::Isa::Sse2, OB::Kernel::Isa::Avx2, OB::Kernel::Isa::Avx512}) {
+        if (!OB::Kernel::supported(isa)) {continue;}
+        OB::Kernel::select(isa);
+        OB::Tone::Oscillator(OB::Tone::to_shape(shape), data.freq, data.rate, OB::Tone::to_phase(phase)).render(osc.data(), osc.size(), 0);
+        auto const [diff, flip] = analytic_diff(data, OB::Tone::to_shape(shape), OB::Tone::to_phase(phase), osc);
+        if (diff > 1 || flip > 0) {
+          fail += (fail.empty() ? " on " : ", ") + OB::Kernel::to_string(isa);
         }
+        max_diff = std::max(max_diff, diff);
+        flips = std::max(flips, flip);
       }
+      print_kv(pad(std::string(shape) + " " + phase), std::to_string(max_diff) + " LSB, " + std::to_string(flips) + " flips" + fail, fail.empty());
     }
   }
-  else if (data.wave == "saw") {
-    for (std::size_t i = 0; i < size; ++i) {
-      for (std::size_t j = 0; j < static_cast<std::size_t>(wave.num_channels); ++j) {
-        // TODO is the impl for saw wave generation correct?
-        // f(x) = -1 * ((2 * a) / pi) * atan(cot(((x * pi) / p)))
-        if (((data.chan == Channel::Right) && (j == 0)) || ((data.chan == Channel::Left) && (j == 1))) {
-          wave.samples.emplace_back(0);
-        }
-        else {
-          wave.samples.emplace_back(-1 * ((2 * (data.ampl * max_amplitude)) / M_PI) * std::atan(std::tan(M_PI_2 - (((i * M_PI) / (data.freq / wave.sample_rate))))));
-        }
+  OB::Kernel::select(prev);
+
+  // the fm feedback loop restarted ahead of every chunk stays within 1 LSB of
+  // one loop run through the tone, at the tone and at the lowest note, for
+  // every feedback short of the noise past 2
+  std::cout << "\n";
+  std::size_t const frames {static_cast<std::size_t>(data.rate)};
+  std::vector<double> tiled (frames);
+  std::vector<double> serial (frames);
+  for (auto const feedback : {0.5, 1.0, 1.5, 2.0}) {
+    double max_err {0};
+    for (auto const freq : {data.freq, 27.5}) {
+      OB::Tone::Fm const fm {{1.0}, {}, feedback, freq, data.rate};
+      fm.render(tiled.data(), frames, 0);
+      fm.reference(serial.data(), frames);
+      for (std::size_t i = 0; i < frames; ++i) {
+        max_err = std::max(max_err, std::fabs(tiled[i] - serial[i]));
       }
     }
+    int const lsb {static_cast<int>(std::ceil(max_err * 32767.0))};
+    print_kv(pad("feedback " + OB::String::to_string(feedback, 1)), std::to_string(lsb) + " LSB", lsb <= 1);
   }
 
-  return wave;
+  if (!pass) {throw std::runtime_error("check failed");}
 }
 
-Track make_track(Wave const& wave, bool const loop) {
-  Track track;
-  if (!track.buf.loadFromSamples(wave.samples.data(), static_cast<sf::Uint64>(wave.num_samples), static_cast<unsigned int>(wave.num_channels), static_cast<unsigned int>(wave.sample_rate))) {
-    throw std::runtime_error("failed to load audio from sample");
+Track::Track(OB::Tone::Source<short> const& source, int const sample_rate, std::size_t const loop, std::size_t const fade) :
+  _source {source},
+  _loop {loop > 0},
+  _ring {_loop ? 1 : OB::Tone::Source<short>::block * source.channels() * 16},
+  _chunk (OB::Tone::Source<short>::block * source.channels()) {
+  initialize(static_cast<unsigned int>(_source.channels()), static_cast<unsigned int>(sample_rate));
+  setPitch(1);
+  setVolume(100);
+  setPosition(0, 0, 0);
+  setRelativeToListener(true);
+
+  if (!_loop) {
+    _thread = std::thread([this]() {produce();});
+    return;
   }
-  track.sound.setLoop(loop);
-  track.sound.setPitch(1);
-  track.sound.setVolume(100);
-  track.sound.setPosition(0, 0, 0);
-  track.sound.setRelativeToListener(true);
-  track.sound.setBuffer(track.buf);
-  return track;
+
+  // the loop runs into the frames that follow it, mixing them into its head
+  // makes the last frame lead into the first as it would in the tone
+  std::size_t const channels {_source.channels()};
+  std::vector<short> frames ((loop + fade) * channels);
+  _source.render(frames.data(), loop + fade, 0);
+  for (std::size_t i = 0; i < fade * channels; ++i) {
+    double const weight {(static_cast<double>(i / channels) + 0.5) / static_cast<double>(fade)};
+    frames[i] = static_cast<short>(std::round(frames[i] * weight + frames[loop * channels + i] * (1.0 - weight)));
+  }
+
+  // whole copies of the loop filling at least one block
+  std::size_t const count {(OB::Tone::Source<short>::block + loop - 1) / loop};
+  _chunk.resize(count * loop * channels);
+  for (std::size_t i = 0; i < count; ++i) {
+    std::copy_n(frames.data(), loop * channels, _chunk.data() + i * loop * channels);
+  }
+}
+
+Track::~Track() {
+  // the audio thread must be stopped before the members it reads go away
+  stop();
+  _quit = true;
+  if (_thread.joinable()) {
+    _thread.join();
+  }
+}
+
+void Track::produce() {
+  std::vector<short> buf (_chunk.size());
+  while (!_quit) {
+    std::size_t const frames {_source.render(buf.data(), OB::Tone::Source<short>::block)};
+    if (!frames) {
+      break;
+    }
+    std::size_t const size {frames * _source.channels()};
+    for (std::size_t pos = _ring.push(buf.data(), size); pos < size && !_quit; pos += _ring.push(buf.data() + pos, size - pos)) {
+      sleep(std::chrono::milliseconds(1));
+    }
+  }
+  _done.store(true, std::memory_order_release);
+}
+
+bool Track::onGetData(Chunk& data) {
+  if (_loop) {
+    data.samples = _chunk.data();
+    data.sampleCount = _chunk.size();
+    return true;
+  }
+
+  std::size_t size {_ring.pop(_chunk.data(), _chunk.size())};
+  if (!size && _primed && !_done.load(std::memory_order_acquire)) {
+    _underruns.fetch_add(1, std::memory_order_relaxed);
+  }
+  while (!size) {
+    // everything pushed before 'done' was set is visible once it is read
+    bool const done {_done.load(std::memory_order_acquire)};
+    size = _ring.pop(_chunk.data(), _chunk.size());
+    if (size) {break;}
+    if (done || _quit) {return false;}
+    sleep(std::chrono::milliseconds(1));
+  }
+  _primed = true;
+  data.samples = _chunk.data();
+  data.sampleCount = size;
+  return true;
+}
+
+void Track::onSeek(sf::Time) {
+  // the tone is only ever played from the start
 }
 
 bool is_playing(Track const& track) {
-  return track.sound.getStatus() == sf::Sound::Playing;
+  return track.getStatus() == sf::SoundStream::Playing;
+}
+
+std::size_t draw_size(Data const& data) {
+  // draw_wave reads at most one period, clipped to the terminal width
+  std::size_t width {0};
+  std::size_t height {0};
+  OB::Term::size(width, height);
+  std::size_t const wave_period {static_cast<std::size_t>(std::round(data.rate / data.freq))};
+  return std::max(std::size_t {1}, std::min(wave_period, width > 20 ? width - 20 : 0));
 }
 
 void draw_wave(Wave const& wave, Data const& data, Track const* track) {
@@ -338,11 +943,11 @@ void draw_wave(Wave const& wave, Data const& data, Track const* track) {
     aec::cursor_get(curs_x, curs_y);
     cursor_y = curs_y;
 
-    std::size_t const wave_size {wave.samples.size() / static_cast<std::size_t>(wave.num_channels)};
-    std::size_t const wave_period {static_cast<std::size_t>(std::round(wave.sample_rate / data.freq))};
+    std::size_t const wave_period {static_cast<std::size_t>(std::round(wave.rate() / data.freq))};
+    std::size_t const channel {data.chan == Channel::Right ? std::size_t {1} : 0};
     // TODO if screen size is smaller than wave period, scroll animate the wave
-    for (std::size_t x = 0; x < width && x < wave_size && x < wave_period; ++x) {
-      double s = wave.samples[(x * static_cast<std::size_t>(wave.num_channels)) + (data.chan == Channel::Right ? 1 : 0)];
+    for (std::size_t x = 0; x < width && x < wave.frames() && x < wave_period; ++x) {
+      double s = wave.at(x, channel);
       std::size_t const y {static_cast<std::size_t>(std::round(scale(s, -32768.0, 32767.0, 0.0, static_cast<double>(height))))};
       if (use_color) {
         OB::Prism::HSLA color {0, 100, 50, 1.0};
@@ -355,7 +960,9 @@ void draw_wave(Wave const& wave, Data const& data, Track const* track) {
       if (track) {
         std::cout << std::flush;
         if (is_playing(*track)) {
-          sleep(std::chrono::milliseconds(static_cast<int>(std::round(data.time * 1000 / (wave_period < width ? wave_period : width)))));
+          // an infinite tone is drawn at the pace of a one second one
+          double const duration {std::isinf(data.time) ? 1.0 : data.time};
+          sleep(std::chrono::milliseconds(static_cast<int>(std::round(duration * 1000 / (wave_period < width ? wave_period : width)))));
         }
       }
     }
@@ -364,14 +971,173 @@ void draw_wave(Wave const& wave, Data const& data, Track const* track) {
   }
 }
 
-void save_to_file(Wave const& wave, std::string const& output) {
-  sf::SoundBuffer buf;
-  if (!buf.loadFromSamples(wave.samples.data(), static_cast<sf::Uint64>(wave.num_samples), static_cast<unsigned int>(wave.num_channels), static_cast<unsigned int>(wave.sample_rate))) {
-    throw std::runtime_error("failed to load audio from sample");
+template<typename T>
+void write_wav(Data const& data, std::string const& output, OB::Pcm::Format const format) {
+  // stream the tone through a fixed buffer, rendering each stretch on all jobs
+  // and encoding it in place
+  std::size_t const size {tone_size(data)};
+  auto const source {make_source<T>(data, size, format)};
+  OB::Wav::Writer writer {output, data.rate, source.channels(), format};
+  std::size_t const stretch {OB::Tone::Source<T>::block * 64 * data.jobs};
+  std::vector<T> buf (stretch * source.channels());
+  for (std::size_t pos = 0; pos < size && !interrupted; pos += stretch) {
+    std::size_t const len {std::min(stretch, size - pos)};
+    render_source(source, buf.data(), pos, len, data.jobs);
+    writer.write(reinterpret_cast<char const*>(buf.data()), OB::Pcm::encode(format, buf.data(), len * source.channels()));
+  }
+  writer.close();
+}
+
+// name of the output at another rate, 'tone.wav' at 48000Hz is 'tone-48000.wav'
+std::string rate_path(std::string const& output, int const rate) {
+  return output.substr(0, output.size() - 4) + "-" + std::to_string(rate) + output.substr(output.size() - 4);
+}
+
+// frame of a stream at 'to' Hz falling at frame 'frame' of one at 'from' Hz
+std::size_t rate_frame(std::size_t const frame, int const from, int const to) {
+  auto const f {static_cast<std::size_t>(from)};
+  auto const t {static_cast<std::size_t>(to)};
+  return frame / f * t + frame % f * t / f;
+}
+
+template<typename T>
+void write_wavs(Data const& data, std::string const& output, OB::Pcm::Format const format) {
+  // every stretch of the tone is synthesized once onto a tape, the file at
+  // the tone rate plays it back and the others resample it
+  auto const gen {make_generator(data)};
+  OB::Tone::Tape tape {gen};
+  OB::Tone::Generator const play {[&tape](double* out, std::size_t const frames, std::size_t const start) {tape.render(out, frames, start);}};
+
+  struct Output {
+    int rate;
+    std::shared_ptr<OB::Tone::Resample const> stage;
+    OB::Tone::Source<T> source;
+    OB::Wav::Writer writer;
+    std::vector<T> buf;
+    std::size_t pos {0};
+    std::size_t end {0};
+  };
+
+  std::size_t const size {tone_size(data)};
+  std::size_t const stretch {OB::Tone::Source<T>::block * 64 * data.jobs};
+  std::vector<Output> outputs;
+  outputs.reserve(data.extra_rates.size() + 1);
+  auto const source {make_source<T>(data, play, data.rate, size, format)};
+  outputs.push_back({data.rate, nullptr, source, OB::Wav::Writer {output, data.rate, source.channels(), format}, std::vector<T>(stretch * source.channels())});
+  for (auto const rate : data.extra_rates) {
+    auto const stage {std::make_shared<OB::Tone::Resample const>(play, data.rate, rate)};
+    auto const resampled {make_source<T>(data, [stage](double* out, std::size_t const frames, std::size_t const start) {stage->render(out, frames, start);}, rate, tone_size(data, rate), format)};
+    std::size_t const room {rate_frame(stretch, data.rate, rate) + 1};
+    outputs.push_back({rate, stage, resampled, OB::Wav::Writer {rate_path(output, rate), rate, resampled.channels(), format}, std::vector<T>(room * resampled.channels())});
+  }
+
+  for (std::size_t pos = 0; pos < size && !interrupted; pos += stretch) {
+    std::size_t const end {pos + std::min(stretch, size - pos)};
+
+    // the stretch of the tape covers the frames every output reads for its
+    // share of this stretch, including the lead of a dithered block
+    std::int64_t lo {static_cast<std::int64_t>(pos)};
+    std::int64_t hi {static_cast<std::int64_t>(end)};
+    for (auto& out : outputs) {
+      out.end = end == size ? out.source.size() : std::min(out.source.size(), rate_frame(end, data.rate, out.rate));
+      if (!out.stage || out.end == out.pos) {continue;}
+      std::size_t from {out.pos - out.pos % OB::Tone::Oscillator::renorm};
+      from -= std::min(from, OB::Dither::Quantizer::warmup);
+      auto const& resampler {out.stage->resampler()};
+      lo = std::min(lo, static_cast<std::int64_t>(resampler.first(from)));
+      hi = std::max(hi, static_cast<std::int64_t>(resampler.first(out.end - 1) + resampler.taps()));
+    }
+    double* const frames {tape.record(static_cast<std::size_t>(lo), static_cast<std::size_t>(hi - lo))};
+    run_jobs(data.jobs, static_cast<std::size_t>(hi - lo), OB::Tone::Oscillator::renorm, [&](std::size_t const begin, std::size_t const last) {
+      gen(frames + begin, last - begin, static_cast<std::size_t>(lo) + begin);
+    });
+
+    for (auto& out : outputs) {
+      std::size_t const len {out.end - out.pos};
+      render_source(out.source, out.buf.data(), out.pos, len, data.jobs);
+      out.writer.write(reinterpret_cast<char const*>(out.buf.data()), OB::Pcm::encode(format, out.buf.data(), len * out.source.channels()));
+      out.pos = out.end;
+    }
+  }
+  for (auto& out : outputs) {
+    out.writer.close();
+  }
+}
+
+void save_to_file(Data const& data, std::string const& output) {
+  // wav files go through the native writer, which switches to rf64 past the
+  // 4GB limit of riff and takes every sample format, other formats are
+  // encoded by sfml in 16 bits
+  auto const format {OB::Pcm::to_format(data.format)};
+  bool const wav {output.size() >= 4 && OB::String::lowercase(output.substr(output.size() - 4)) == ".wav"};
+  writing = true;
+  if (wav && data.extra_rates.size()) {
+    switch (format) {
+      case OB::Pcm::Format::S24:
+      case OB::Pcm::Format::S32: write_wavs<std::int32_t>(data, output, format); break;
+      case OB::Pcm::Format::F32: write_wavs<float>(data, output, format); break;
+      default: write_wavs<short>(data, output, format); break;
+    }
+    return;
   }
-  if (!buf.saveToFile(output)) {
+  if (wav) {
+    switch (format) {
+      case OB::Pcm::Format::S24:
+      case OB::Pcm::Format::S32: write_wav<std::int32_t>(data, output, format); break;
+      case OB::Pcm::Format::F32: write_wav<float>(data, output, format); break;
+      default: write_wav<short>(data, output, format); break;
+    }
+    return;
+  }
+  if (data.extra_rates.size()) {
+    throw std::runtime_error("invalid rates '" + data.rates + "' for '" + output + "', only wav files take them");
+  }
+  if (format != OB::Pcm::Format::S16) {
+    throw std::runtime_error("invalid format '" + data.format + "' for '" + output + "', only wav files take it");
+  }
+
+  std::size_t const size {tone_size(data)};
+  auto const source {make_source<short>(data, size)};
+  sf::OutputSoundFile file;
+  if (!file.openFromFile(output, static_cast<unsigned int>(data.rate), static_cast<unsigned int>(source.channels()))) {
     throw std::runtime_error("failed to save audio to '" + output + "'");
   }
+  std::size_t const stretch {OB::Tone::Source<short>::block * 64 * data.jobs};
+  std::vector<short> buf (stretch * source.channels());
+  for (std::size_t pos = 0; pos < size && !interrupted; pos += stretch) {
+    std::size_t const len {std::min(stretch, size - pos)};
+    render_source(source, buf.data(), pos, len, data.jobs);
+    file.write(buf.data(), static_cast<sf::Uint64>(len * source.channels()));
+  }
+}
+
+template<typename T>
+void write_pcm(Data const& data, OB::Pcm::Format const format) {
+  // render straight into the writer buffers, each one on all jobs, and
+  // encode in place
+  std::size_t const size {tone_size(data)};
+  auto const source {make_source<T>(data, size, format)};
+  OB::Pcm::Writer writer {STDOUT_FILENO, OB::Pcm::width(format) * source.channels(), sizeof(T) * source.channels()};
+  for (std::size_t pos = 0; pos < size;) {
+    std::size_t const len {std::min(writer.frames(), size - pos)};
+    render_source(source, reinterpret_cast<T*>(writer.data()), pos, len, data.jobs);
+    OB::Pcm::encode(format, writer.data(), len * source.channels());
+    writer.commit(len);
+    pos += len;
+  }
+}
+
+void save_to_stdout(Data const& data) {
+  if (data.extra_rates.size()) {
+    throw std::runtime_error("invalid rates '" + data.rates + "' for '-', only wav files take them");
+  }
+  auto const format {OB::Pcm::to_format(data.format)};
+  switch (format) {
+    case OB::Pcm::Format::S24:
+    case OB::Pcm::Format::S32: write_pcm<std::int32_t>(data, format); break;
+    case OB::Pcm::Format::F32: write_pcm<float>(data, format); break;
+    default: write_pcm<short>(data, format); break;
+  }
 }
 
 Data make_data(Parg& pg) {
@@ -410,13 +1176,119 @@ Data make_data(Parg& pg) {
     }
   }
 
-  data.time = pg.get<double>("time");
+  {
+    auto const time_str {pg.get<std::string>("time")};
+    if (time_str == "inf") {
+      data.time = std::numeric_limits<double>::infinity();
+    }
+    else {
+      try {
+        data.time = std::stod(time_str);
+      }
+      catch (...) {
+        throw std::runtime_error("invalid time '" + time_str + "'");
+      }
+      if (!(data.time >= 0) || std::isinf(data.time)) {throw std::runtime_error("invalid time '" + time_str + "'");}
+    }
+  }
   data.loop = pg.get<bool>("loop");
   if (data.loop && data.time == 0) {data.time = 1;}
 
   data.wave = pg.get<std::string>("wave");
+  data.table = pg.get<std::string>("table");
+  if (data.loop && data.table.empty() && is_noise(data.wave)) {throw std::runtime_error("invalid loop for wave '" + data.wave + "', noise never repeats");}
+  if (data.table.size()) {
+    // the first channel of the file holds the cycle
+    auto const cycle {OB::Wav::read(data.table)};
+    if (cycle.frames() < 2) {throw std::runtime_error("invalid table '" + data.table + "'");}
+    data.wavetable = std::make_shared<OB::Tone::Wavetable const>(cycle.channel(0), cycle.frames(), cycle.stride());
+  }
+  {
+    auto const harmonics {pg.get<int>("harmonics")};
+    if (harmonics < 1 || harmonics > 4096) {throw std::runtime_error("invalid harmonics '" + std::to_string(harmonics) + "'");}
+    data.harmonics = static_cast<std::size_t>(harmonics);
+  }
+  data.rolloff = pg.get<double>("rolloff");
+  if (!std::isfinite(data.rolloff)) {throw std::runtime_error("invalid rolloff '" + pg.get<std::string>("rolloff") + "'");}
+  data.ratio = pg.get<std::string>("ratio");
+  data.index = pg.get<std::string>("index");
+  {
+    auto const parse = [](std::string const& list, std::string const& name) {
+      std::vector<double> res;
+      if (list.empty()) {return res;}
+      for (auto const& str : OB::String::split(list, ",")) {
+        double val {0};
+        std::size_t end {0};
+        try {
+          val = std::stod(str, &end);
+        }
+        catch (...) {
+          throw std::runtime_error("invalid " + name + " '" + list + "'");
+        }
+        if (end != str.size() || !std::isfinite(val)) {throw std::runtime_error("invalid " + name + " '" + list + "'");}
+        res.emplace_back(val);
+      }
+      return res;
+    };
+    data.ratios = parse(data.ratio, "ratio");
+    data.indexes = parse(data.index, "index");
+    if (data.ratios.empty()) {throw std::runtime_error("invalid ratio '" + data.ratio + "'");}
+    for (auto const ratio : data.ratios) {
+      if (!(ratio > 0)) {throw std::runtime_error("invalid ratio '" + data.ratio + "'");}
+    }
+    if (data.indexes.size() + 1 != data.ratios.size()) {throw std::runtime_error("invalid index '" + data.index + "' for ratio '" + data.ratio + "'");}
+  }
+  data.feedback = pg.get<double>("feedback");
+  if (!std::isfinite(data.feedback)) {throw std::runtime_error("invalid feedback '" + pg.get<std::string>("feedback") + "'");}
+  data.phase = pg.get<std::string>("phase");
+  data.precision = pg.get<std::string>("precision");
+  data.antialias = pg.get<std::string>("antialias");
+  {
+    auto const oversample {pg.get<int>("oversample")};
+    if (oversample != 1 && oversample != 2 && oversample != 4 && oversample != 8) {throw std::runtime_error("invalid oversample '" + std::to_string(oversample) + "'");}
+    data.oversample = static_cast<std::size_t>(oversample);
+  }
+  data.format = pg.get<std::string>("format");
+  data.dither = pg.get<std::string>("dither");
+  {
+    auto const seed_str {pg.get<std::string>("seed")};
+    unsigned long long seed {0};
+    std::size_t end {0};
+    try {
+      seed = std::stoull(seed_str, &end);
+    }
+    catch (...) {
+      throw std::runtime_error("invalid seed '" + seed_str + "'");
+    }
+    if (end != seed_str.size() || seed > std::numeric_limits<std::uint32_t>::max() || seed_str.find('-') != std::string::npos) {throw std::runtime_error("invalid seed '" + seed_str + "'");}
+    data.seed = static_cast<std::uint32_t>(seed);
+  }
+  data.shaping = pg.get<std::string>("shaping");
   data.rate = pg.get<int>("rate");
+  data.rates = pg.get<std::string>("rates");
+  if (data.rates.size()) {
+    for (auto const& str : OB::String::split(data.rates, ",")) {
+      int rate {0};
+      std::size_t end {0};
+      try {
+        rate = std::stoi(str, &end);
+      }
+      catch (...) {
+        throw std::runtime_error("invalid rates '" + data.rates + "'");
+      }
+      if (end != str.size() || rate <= 0 || rate == data.rate || std::find(data.extra_rates.begin(), data.extra_rates.end(), rate) != data.extra_rates.end()) {
+        throw std::runtime_error("invalid rates '" + data.rates + "'");
+      }
+      data.extra_rates.emplace_back(rate);
+    }
+  }
   data.ampl = pg.get<double>("amplitude");
+
+  {
+    auto const jobs {pg.get<int>("jobs")};
+    if (jobs < 0) {throw std::runtime_error("invalid jobs '" + std::to_string(jobs) + "'");}
+    data.jobs = jobs ? static_cast<std::size_t>(jobs) : std::max(1u, std::thread::hardware_concurrency());
+  }
   data.size = data.sos / data.freq;
 
   return data;
@@ -439,17 +1311,69 @@ void print_data(Data const& data) {
     std::cout << aec::wrap(key, style.key, use_color) << aec::wrap(": ", style.punc, use_color) << aec::wrap(value, style.value, use_color) << " " << aec::wrap(unit, style.unit, use_color) << "\n";
   };
 
-  print_kvu("  a4", data.a4, "Hz");
-  print_kvu(" sos", data.sos, "m/s");
-  print_kv("note", freq_to_note(data.freq, data.a4));
-  print_kvu("freq", data.freq, "Hz");
-  print_kvu("size", data.size, "m");
-  print_kv("wave", data.wave);
-  print_kvu("rate", data.rate, "Hz");
-  print_kv("ampl", data.ampl);
-  print_kv("chan", channel_str.at(static_cast<std::size_t>(data.chan)));
-  print_kvu("time", data.time, "s");
-  print_kv("loop", data.loop);
+  print_kvu("   a4", data.a4, "Hz");
+  print_kvu("  sos", data.sos, "m/s");
+  print_kv(" note", freq_to_note(data.freq, data.a4));
+  print_kvu(" freq", data.freq, "Hz");
+  print_kvu(" size", data.size, "m");
+  print_kv(" wave", data.wavetable ? data.table : data.wave);
+  if (!data.wavetable && data.wave == "additive") {
+    print_kv(" harm", data.harmonics);
+    print_kv(" roll", data.rolloff);
+  }
+  if (!data.wavetable && data.wave == "fm") {
+    print_kv("ratio", data.ratio);
+    print_kvu("index", data.index, "rad");
+    print_kvu(" feed", data.feedback, "rad");
+  }
+  print_kv("phase", data.phase);
+  print_kv(" prec", data.precision);
+  print_kv(" anti", data.antialias);
+  print_kv(" over", data.oversample);
+  print_kvu(" rate", data.rate, "Hz");
+  if (data.rates.size()) {
+    print_kvu("rates", data.rates, "Hz");
+  }
+  print_kv(" ampl", data.ampl);
+  print_kv(" dith", data.dither);
+  if ((is_noise(data.wave) && !data.wavetable) || data.dither != "none") {
+    print_kv(" seed", data.seed);
+  }
+  print_kv("shape", data.shaping);
+  print_kv(" chan", channel_str.at(static_cast<std::size_t>(data.chan)));
+  print_kvu(" time", data.time, "s");
+  print_kv(" loop", data.loop);
+  print_kv(" jobs", data.jobs);
+}
+
+void print_cpu_info() {
+  struct Style {
+    std::string punc {aec::fg_true("c0c0c0")};
+    std::string key {aec::fg_true("ff54ff")};
+    std::string value {aec::fg_true("54ff54")};
+  };
+  Style style;
+
+  auto const print_kv = [&](auto const& key, auto const& value) {
+    std::cout << aec::wrap(std::string(key.size() < 7 ? 7 - key.size() : 0, ' ') + key, style.key, use_color) << aec::wrap(": ", style.punc, use_color) << aec::wrap(value, style.value, use_color) << "\n";
+  };
+
+  for (auto const& [name, supported] : OB::Kernel::features()) {
+    print_kv(name, supported ? "yes" : "no");
+  }
+  print_kv(std::string("kernel"), OB::Kernel::to_string(OB::Kernel::active().isa));
+}
+
+void print_track(Track const& track) {
+  struct Style {
+    std::string punc {aec::fg_true("c0c0c0")};
+    std::string key {aec::fg_true("ff54ff")};
+    std::string value {aec::fg_true("54ff54")};
+    std::string unit {aec::fg_true("c0c0c0")};
+  };
+  Style style;
+
+  std::cout << aec::wrap(" xrun", style.key, use_color) << aec::wrap(": ", style.punc, use_color) << aec::wrap(track.underruns(), style.value, use_color) << " " << aec::wrap("underruns", style.unit, use_color) << "\n";
 }
 
 int main(int argc, char** argv) {
@@ -468,21 +1392,63 @@ int main(int argc, char** argv) {
     std::signal(SIGINT, signal_handler);
     std::signal(SIGTERM, signal_handler);
 
+    auto const kernel {pg.get<std::string>("kernel")};
+    OB::Kernel::select(kernel == "auto" ? OB::Kernel::detect() : OB::Kernel::to_isa(kernel));
+
+    if (pg.get<bool>("cpu-info")) {
+      print_cpu_info();
+      return 0;
+    }
+
     auto data = make_data(pg);
+
+    // stdout carries the samples, so nothing else is printed to it
+    if (pg.find("output") && pg.get<std::string>("output") == "-") {
+      save_to_stdout(data);
+      return 0;
+    }
+
     print_data(data);
 
-    auto wave = make_wave(data);
+    if (pg.get<bool>("bench") || pg.get<bool>("check")) {
+      if (pg.get<bool>("bench")) {bench_wave(data);}
+      if (pg.get<bool>("check")) {check(data);}
+      return 0;
+    }
+
     if (pg.find("output")) {
-      save_to_file(wave, pg.get<std::string>("output"));
+      save_to_file(data, pg.get<std::string>("output"));
+      return 0;
     }
-    else if (data.time > 0.0) {
-      auto track = make_track(wave, data.loop);
-      track.sound.play();
-      if (is_term) {draw_wave(wave, data, &track);}
-      while (is_playing(track)) {sleep(std::chrono::milliseconds(20));}
+
+    if (data.time > 0.0) {
+      // only the drawn frames are rendered up front, playback streams the rest
+      auto const wave = make_wave(data, draw_size(data));
+      std::unique_ptr<Track> track;
+      if (data.loop) {
+        // the shortest loop of whole cycles whose seam stays under one 16-bit
+        // step, or the closest one with its seam crossfaded
+        double const tolerance {1.0 / (2.0 * M_PI * 32768.0)};
+        auto const loop {tone_loop(data, OB::Tone::Source<short>::block * 16, tolerance)};
+        if (loop.frames) {
+          std::size_t const fade {loop.error > tolerance ? std::min(loop.frames / 2, OB::Tone::Source<short>::block) : 0};
+          track = std::make_unique<Track>(make_source<short>(data, loop.frames + fade), data.rate, loop.frames, fade);
+        }
+        else {
+          // not even one cycle fits in a loop, the tone streams without end instead
+          track = std::make_unique<Track>(make_source<short>(data, std::numeric_limits<std::size_t>::max()), data.rate);
+        }
+      }
+      else {
+        track = std::make_unique<Track>(make_source<short>(data, tone_size(data)), data.rate);
+      }
+      track->play();
+      if (is_term) {draw_wave(wave, data, track.get());}
+      while (is_playing(*track)) {sleep(std::chrono::milliseconds(20));}
+      print_track(*track);
     }
-    else {
-      if (is_term) {draw_wave(wave, data);}
+    else if (is_term) {
+      draw_wave(make_wave(data, draw_size(data)), data);
     }
   }
   catch(std::exception const& e) {
@@ -0,0 +1,243 @@
+/*
+                                    88888888
+                                  888888888888
+                                 88888888888888
+                                8888888888888888
+                               888888888888888888
+                              888888  8888  888888
+                              88888    88    88888
+                              888888  8888  888888
+                              88888888888888888888
+                              88888888888888888888
+                             8888888888888888888888
+                          8888888888888888888888888888
+                        88888888888888888888888888888888
+                              88888888888888888888
+                            888888888888888888888888
+                           888888  8888888888  888888
+                           888     8888  8888     888
+                                   888    888
+
+                                   OCTOBANANA
+
+Licensed under the MIT License
+
+Copyright (c) 2020 Brett Robinson <https://octobanana.com/>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef OB_BUFFER_HH
+#define OB_BUFFER_HH
+
+#include "ob/kernel.hh"
+
+#include <cstddef>
+#include <cstdint>
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+
+namespace OB {
+
+// Order of the samples of a Buffer, interleaved frames or one plane per channel.
+enum class Order {
+  Interleaved,
+  Planar,
+};
+
+// Multichannel block of samples at a sample rate. Sinks take interleaved
+// frames, while processing that works a channel at a time runs on planar
+// buffers, the interleave and deinterleave functions below move between them.
+template<typename T, Order O = Order::Interleaved>
+class Buffer {
+public:
+  static constexpr Order order {O};
+
+  Buffer() = default;
+  Buffer(std::size_t const channels, int const rate, std::size_t const frames = 0) :
+    _channels {channels},
+    _rate {rate},
+    _frames {frames},
+    _samples(channels * frames) {
+    if (_channels < 1) {
+      throw std::runtime_error("invalid channels '" + std::to_string(_channels) + "'");
+    }
+  }
+  Buffer(Buffer&&) = default;
+  Buffer(Buffer const&) = default;
+
+  ~Buffer() = default;
+
+  Buffer& operator=(Buffer&&) = default;
+  Buffer& operator=(Buffer const&) = default;
+
+  std::size_t channels() const {
+    return _channels;
+  }
+
+  int rate() const {
+    return _rate;
+  }
+
+  std::size_t frames() const {
+    return _frames;
+  }
+
+  // number of samples across all channels
+  std::size_t size() const {
+    return _samples.size();
+  }
+
+  T* data() {
+    return _samples.data();
+  }
+
+  T const* data() const {
+    return _samples.data();
+  }
+
+  // distance between consecutive samples of one channel
+  std::size_t stride() const {
+    return O == Order::Interleaved ? _channels : 1;
+  }
+
+  // first sample of a channel, the rest follow every stride() samples
+  T* channel(std::size_t const channel) {
+    return _samples.data() + offset(0, channel);
+  }
+
+  T const* channel(std::size_t const channel) const {
+    return _samples.data() + offset(0, channel);
+  }
+
+  T& at(std::size_t const frame, std::size_t const channel) {
+    return _samples[offset(frame, channel)];
+  }
+
+  T const& at(std::size_t const frame, std::size_t const channel) const {
+    return _samples[offset(frame, channel)];
+  }
+
+  // keeps the first frames of every channel, new frames are zero
+  void resize(std::size_t const frames) {
+    if (O == Order::Planar && _channels > 1) {
+      std::vector<T> samples(_channels * frames);
+      std::size_t const len {std::min(frames, _frames)};
+      for (std::size_t c = 0; c < _channels; ++c) {
+        std::copy_n(_samples.data() + c * _frames, len, samples.data() + c * frames);
+      }
+      _samples = std::move(samples);
+    }
+    else {
+      _samples.resize(_channels * frames);
+    }
+    _frames = frames;
+  }
+
+private:
+  std::size_t offset(std::size_t const frame, std::size_t const channel) const {
+    return O == Order::Interleaved ? frame * _channels + channel : channel * _frames + frame;
+  }
+
+  std::size_t _channels {1};
+  int _rate {0};
+  std::size_t _frames {0};
+  std::vector<T> _samples;
+};
+
+// Writes 'frames' frames from one plane per channel as interleaved frames to
+// 'out', which may be the buffer of a sink. Stereo 16, 32 and 64-bit samples
+// go through the vector kernels.
+template<typename T>
+void interleave(T* out, T const* const* planes, std::size_t const channels, std::size_t const frames) {
+  auto const& kernel {OB::Kernel::active()};
+  if (channels == 1) {
+    std::copy_n(planes[0], frames, out);
+  }
+  else if (channels == 2 && sizeof(T) == 2) {
+    kernel.interleave16(reinterpret_cast<std::uint16_t*>(out), reinterpret_cast<std::uint16_t const*>(planes[0]), reinterpret_cast<std::uint16_t const*>(planes[1]), frames);
+  }
+  else if (channels == 2 && sizeof(T) == 4) {
+    kernel.interleave32(reinterpret_cast<std::uint32_t*>(out), reinterpret_cast<std::uint32_t const*>(planes[0]), reinterpret_cast<std::uint32_t const*>(planes[1]), frames);
+  }
+  else if (channels == 2 && sizeof(T) == 8) {
+    kernel.interleave64(reinterpret_cast<std::uint64_t*>(out), reinterpret_cast<std::uint64_t const*>(planes[0]), reinterpret_cast<std::uint64_t const*>(planes[1]), frames);
+  }
+  else {
+    for (std::size_t i = 0; i < frames; ++i) {
+      for (std::size_t c = 0; c < channels; ++c) {
+        out[i * channels + c] = planes[c][i];
+      }
+    }
+  }
+}
+
+// Splits 'frames' interleaved frames from 'in' into one plane per channel.
+template<typename T>
+void deinterleave(T* const* planes, T const* in, std::size_t const channels, std::size_t const frames) {
+  auto const& kernel {OB::Kernel::active()};
+  if (channels == 1) {
+    std::copy_n(in, frames, planes[0]);
+  }
+  else if (channels == 2 && sizeof(T) == 2) {
+    kernel.deinterleave16(reinterpret_cast<std::uint16_t*>(planes[0]), reinterpret_cast<std::uint16_t*>(planes[1]), reinterpret_cast<std::uint16_t const*>(in), frames);
+  }
+  else if (channels == 2 && sizeof(T) == 4) {
+    kernel.deinterleave32(reinterpret_cast<std::uint32_t*>(planes[0]), reinterpret_cast<std::uint32_t*>(planes[1]), reinterpret_cast<std::uint32_t const*>(in), frames);
+  }
+  else if (channels == 2 && sizeof(T) == 8) {
+    kernel.deinterleave64(reinterpret_cast<std::uint64_t*>(planes[0]), reinterpret_cast<std::uint64_t*>(planes[1]), reinterpret_cast<std::uint64_t const*>(in), frames);
+  }
+  else {
+    for (std::size_t i = 0; i < frames; ++i) {
+      for (std::size_t c = 0; c < channels; ++c) {
+        planes[c][i] = in[i * channels + c];
+      }
+    }
+  }
+}
+
+template<typename T>
+Buffer<T, Order::Interleaved> interleave(Buffer<T, Order::Planar> const& in) {
+  Buffer<T, Order::Interleaved> out {in.channels(), in.rate(), in.frames()};
+  std::vector<T const*> planes (in.channels());
+  for (std::size_t c = 0; c < in.channels(); ++c) {
+    planes[c] = in.channel(c);
+  }
+  interleave(out.data(), planes.data(), in.channels(), in.frames());
+  return out;
+}
+
+template<typename T>
+Buffer<T, Order::Planar> deinterleave(Buffer<T, Order::Interleaved> const& in) {
+  Buffer<T, Order::Planar> out {in.channels(), in.rate(), in.frames()};
+  std::vector<T*> planes (in.channels());
+  for (std::size_t c = 0; c < in.channels(); ++c) {
+    planes[c] = out.channel(c);
+  }
+  deinterleave(planes.data(), in.data(), in.channels(), in.frames());
+  return out;
+}
+
+} // namespace OB
+
+#endif // OB_BUFFER_HH
@@ -0,0 +1,190 @@
+/*
+                                    88888888
+                                  888888888888
+                                 88888888888888
+                                8888888888888888
+                               888888888888888888
+                              888888  8888  888888
+                              88888    88    88888
+                              888888  8888  888888
+                              88888888888888888888
+                              88888888888888888888
+                             8888888888888888888888
+                          8888888888888888888888888888
+                        88888888888888888888888888888888
+                              88888888888888888888
+                            888888888888888888888888
+                           888888  8888888888  888888
+                           888     8888  8888     888
+                                   888    888
+
+                                   OCTOBANANA
+
+Licensed under the MIT License
+
+Copyright (c) 2020 Brett Robinson <https://octobanana.com/>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "ob/dither.hh"
+#include "ob/kernel.hh"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include <array>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+namespace OB::Dither {
+
+// largest error fed back, the error of a clipped sample would otherwise
+// drive the filter unstable
+static constexpr double error_max {2.0};
+
+// adding and subtracting 1.5 * 2^52 rounds with ties to even as nearbyint
+// does, without a call in the feedback loop
+static constexpr double round_magic {6755399441055744.0};
+
+static constexpr std::array<double, 5> coefs_first {1.0, 0.0, 0.0, 0.0, 0.0};
+static constexpr std::array<double, 5> coefs_lipshitz {2.033, -2.165, 1.959, -1.590, 0.6149};
+
+static std::uint32_t mix(std::uint32_t x) {
+  x ^= x >> 16;
+  x *= 0x7feb352du;
+  x ^= x >> 15;
+  x *= 0x846ca68bu;
+  x ^= x >> 16;
+  return x;
+}
+
+Type to_type(std::string const& str) {
+  if (str == "none") {return Type::None;}
+  if (str == "tpdf") {return Type::Tpdf;}
+  throw std::runtime_error("invalid dither '" + str + "'");
+}
+
+Shaping to_shaping(std::string const& str) {
+  if (str == "none") {return Shaping::None;}
+  if (str == "first") {return Shaping::First;}
+  if (str == "lipshitz") {return Shaping::Lipshitz;}
+  throw std::runtime_error("invalid shaping '" + str + "'");
+}
+
+Quantizer::Quantizer(Type const type, Shaping const shaping, double const limit, std::uint32_t const seed) :
+  _type {type},
+  _lo {-limit - 1.0},
+  _hi {limit},
+  _seed {seed} {
+  switch (shaping) {
+    case Shaping::First: _order = 1; _coefs = coefs_first; break;
+    case Shaping::Lipshitz: _order = 5; _coefs = coefs_lipshitz; break;
+    default: break;
+  }
+}
+
+// fills 'noise' with the dither of the frames [start, start + size)
+static void fill(double* noise, std::size_t size, std::uint64_t start, std::uint32_t const seed, std::size_t const channel) {
+  auto const& kernel {OB::Kernel::active()};
+  while (size) {
+    // the kernel counts frames in 32 bits, the rest of the frame goes into the key
+    std::uint32_t const counter {static_cast<std::uint32_t>(start)};
+    std::size_t const len {static_cast<std::size_t>(std::min<std::uint64_t>(size, (std::uint64_t {1} << 32) - counter))};
+    std::uint32_t const key {mix(seed ^ mix(static_cast<std::uint32_t>(channel) ^ mix(static_cast<std::uint32_t>(start >> 32))))};
+    kernel.tpdf(noise, len, key, counter);
+    noise += len;
+    start += len;
+    size -= len;
+  }
+}
+
+// runs a shaping filter from rest over 'size' frames, as one run of the
+// shape kernel does, and writes all but the first 'lead' steps
+static void shape(double* out, double const* in, double const* noise, std::size_t const lead, std::size_t const size, double const gain, std::array<double, 5> const& coefs, double const lo, double const hi) {
+  // the last errors, most recent first, every filter runs all five taps
+  double e0 {0}, e1 {0}, e2 {0}, e3 {0}, e4 {0};
+  auto const [c0, c1, c2, c3, c4] = coefs;
+  for (std::size_t i = 0; i < size; ++i) {
+    // the newest error goes in last, the rest of the sum is off the feedback path
+    double const val {(in[i] * gain - (c4 * e4 + c3 * e3 + c2 * e2 + c1 * e1)) - c0 * e0};
+    double const step {(std::min(std::max(val + noise[i], lo), hi) + round_magic) - round_magic};
+    e4 = e3;
+    e3 = e2;
+    e2 = e1;
+    e1 = e0;
+    e0 = std::min(std::max(step - val, -error_max), error_max);
+    if (i >= lead) {out[i] = step;}
+  }
+}
+
+void Quantizer::apply(double* out, double const* in, std::size_t size, std::uint64_t start, std::size_t const channel, double const gain) const {
+  auto const& kernel {OB::Kernel::active()};
+  // scratch is kept per thread across calls, jobs render at the same time
+  thread_local std::vector<double> buf;
+  buf.resize(std::max(buf.size(), warmup + lanes * span));
+  double* const noise {buf.data()};
+  if (_type != Type::Tpdf) {
+    std::fill_n(noise, warmup + lanes * span, 0.0);
+  }
+  if (!_order) {
+    while (size) {
+      std::size_t const len {std::min(size, span)};
+      if (_type == Type::Tpdf) {
+        fill(noise, len, start, _seed, channel);
+      }
+      kernel.requantize(out, in, noise, len, gain, _lo, _hi);
+      out += len;
+      in += len;
+      start += len;
+      size -= len;
+    }
+    return;
+  }
+
+  // the filter of each piece starts 'warmup' frames ahead of it, or where the
+  // run starts if that is later. The pieces are taken from the last, so when
+  // 'out' is 'in' a filter has read its lead before the piece ahead of it is
+  // written over it
+  std::uint64_t hi {start + size};
+  while (hi > start) {
+    std::uint64_t const first {std::max<std::uint64_t>((hi - 1) / span * span, start)};
+    std::uint64_t const from {std::max<std::uint64_t>(first - std::min<std::uint64_t>(first, warmup), start)};
+    std::size_t const lead {static_cast<std::size_t>(first - from)};
+    std::size_t const len {static_cast<std::size_t>(hi - from)};
+    // whole pieces with a whole lead are shaped four at a time
+    bool const whole {len == warmup + span && lead == warmup && first >= start + (lanes - 1) * span + warmup};
+    std::uint64_t const lo {whole ? from - (lanes - 1) * span : from};
+    if (_type == Type::Tpdf) {
+      fill(noise, static_cast<std::size_t>(hi - lo), lo, _seed, channel);
+    }
+    std::size_t const at {static_cast<std::size_t>(lo - start)};
+    if (whole) {
+      kernel.shape(out + at, in + at, noise, len, span, lead, _coefs.data(), gain, _lo, _hi, error_max);
+    }
+    else {
+      shape(out + at, in + at, noise, lead, len, gain, _coefs, _lo, _hi);
+    }
+    hi = lo + lead;
+  }
+}
+
+} // namespace OB::Dither
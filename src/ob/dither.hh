@@ -0,0 +1,124 @@
+/*
+                                    88888888
+                                  888888888888
+                                 88888888888888
+                                8888888888888888
+                               888888888888888888
+                              888888  8888  888888
+                              88888    88    88888
+                              888888  8888  888888
+                              88888888888888888888
+                              88888888888888888888
+                             8888888888888888888888
+                          8888888888888888888888888888
+                        88888888888888888888888888888888
+                              88888888888888888888
+                            888888888888888888888888
+                           888888  8888888888  888888
+                           888     8888  8888     888
+                                   888    888
+
+                                   OCTOBANANA
+
+Licensed under the MIT License
+
+Copyright (c) 2020 Brett Robinson <https://octobanana.com/>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef OB_DITHER_HH
+#define OB_DITHER_HH
+
+#include <cstddef>
+#include <cstdint>
+
+#include <array>
+#include <string>
+
+namespace OB::Dither {
+
+enum class Type {
+  None,
+  Tpdf,
+};
+
+// Error feedback filters, 'first' pushes the noise up at 6dB per octave and
+// 'lipshitz' is the 5-tap E-weighted filter by Lipshitz et al. that moves it
+// out of the bands hearing is most sensitive to, tuned for 44.1kHz.
+enum class Shaping {
+  None,
+  First,
+  Lipshitz,
+};
+
+Type to_type(std::string const& str);
+Shaping to_shaping(std::string const& str);
+
+// Rounds samples to whole steps of the output format within [-limit - 1,
+// limit], adding triangular dither of up to one step either way and feeding
+// the rounding error back through the shaping filter. The dither is a hash
+// of the frame, channel and seed. Each 'span' frames of the grid are shaped
+// by a filter of their own, started from rest 'warmup' frames ahead of them
+// or where the run starts if that is later, so a frame comes out the same in
+// every run that starts 'warmup' or more frames ahead of its piece.
+class Quantizer {
+public:
+  // frames a run is started ahead of the first wanted one, for the shaping
+  // filter to settle
+  static constexpr std::size_t warmup {32};
+  // frames each shaping filter covers
+  static constexpr std::size_t span {1024};
+  // pieces shaped side by side, a run covering as many is shaped fastest
+  static constexpr std::size_t lanes {4};
+
+  Quantizer() = default;
+  Quantizer(Type const type, Shaping const shaping, double const limit, std::uint32_t const seed = 0);
+  Quantizer(Quantizer&&) = default;
+  Quantizer(Quantizer const&) = default;
+
+  ~Quantizer() = default;
+
+  Quantizer& operator=(Quantizer&&) = default;
+  Quantizer& operator=(Quantizer const&) = default;
+
+  bool active() const {
+    return _type != Type::None || _order;
+  }
+
+  // frames of history the shaping filter needs
+  std::size_t history() const {
+    return _order ? warmup : 0;
+  }
+
+  // quantizes the normalized samples of one channel for the frames
+  // [start, start + size) after scaling them by 'gain', 'out' may be 'in'
+  void apply(double* out, double const* in, std::size_t size, std::uint64_t start, std::size_t const channel, double const gain) const;
+
+private:
+  Type _type {Type::None};
+  std::size_t _order {0};
+  std::array<double, 5> _coefs {};
+  double _lo {0};
+  double _hi {0};
+  std::uint32_t _seed {0};
+};
+
+} // namespace OB::Dither
+
+#endif // OB_DITHER_HH
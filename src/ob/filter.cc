@@ -0,0 +1,214 @@
+/*
+                                    88888888
+                                  888888888888
+                                 88888888888888
+                                8888888888888888
+                               888888888888888888
+                              888888  8888  888888
+                              88888    88    88888
+                              888888  8888  888888
+                              88888888888888888888
+                              88888888888888888888
+                             8888888888888888888888
+                          8888888888888888888888888888
+                        88888888888888888888888888888888
+                              88888888888888888888
+                            888888888888888888888888
+                           888888  8888888888  888888
+                           888     8888  8888     888
+                                   888    888
+
+                                   OCTOBANANA
+
+Licensed under the MIT License
+
+Copyright (c) 2020 Brett Robinson <https://octobanana.com/>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "ob/filter.hh"
+#include "ob/kernel.hh"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include <string>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <stdexcept>
+
+namespace OB::Filter {
+
+// modified bessel function of the first kind of order zero, by its series
+static double bessel_i0(double const x) {
+  double sum {1};
+  double term {1};
+  for (int k = 1; term > sum * 1e-17; ++k) {
+    term *= (x / (2.0 * k)) * (x / (2.0 * k));
+    sum += term;
+  }
+  return sum;
+}
+
+// shape of the Kaiser window reaching 'atten' dB of stopband attenuation
+static double kaiser_beta(double const atten) {
+  if (atten > 50) {return 0.1102 * (atten - 8.7);}
+  if (atten > 21) {return 0.5842 * std::pow(atten - 21, 0.4) + 0.07886 * (atten - 21);}
+  return 0;
+}
+
+Halfband::Halfband(double const transition, double const atten) {
+  if (!(transition > 0 && transition < 0.5)) {
+    throw std::runtime_error("invalid transition '" + std::to_string(transition) + "'");
+  }
+
+  // taps needed by the Kaiser estimate, rounded up to the 4 * n - 1 taps of a
+  // half-band filter with n odd taps on each side
+  double const length {std::ceil((atten - 7.95) / (14.36 * transition)) + 1};
+  std::size_t const count {std::max<std::size_t>(1, static_cast<std::size_t>(std::ceil((length + 1) / 4)))};
+  double const beta {kaiser_beta(atten)};
+  double const width {static_cast<double>(2 * count)};
+
+  _taps.resize(count);
+  double sum {0};
+  for (std::size_t j = 0; j < count; ++j) {
+    double const n {static_cast<double>(2 * j + 1)};
+    double const sinc {std::sin(M_PI * n / 2) / (M_PI * n)};
+    _taps[j] = sinc * bessel_i0(beta * std::sqrt(1 - (n / width) * (n / width))) / bessel_i0(beta);
+    sum += _taps[j];
+  }
+  // unity gain at dc, with the center tap at one half
+  for (auto& tap : _taps) {
+    tap *= 0.25 / sum;
+  }
+}
+
+void Halfband::decimate(double* out, double const* in, std::size_t const size, double* even, double* odd) const {
+  if (!size) {return;}
+  auto const& kernel {OB::Kernel::active()};
+  std::size_t const pairs {size + reach() - 1};
+  kernel.deinterleave64(reinterpret_cast<std::uint64_t*>(even), reinterpret_cast<std::uint64_t*>(odd), reinterpret_cast<std::uint64_t const*>(in), pairs);
+  even[pairs] = in[2 * pairs];
+  kernel.halfband(out, even, odd, size, _taps.data(), _taps.size());
+}
+
+Decimator::Decimator(std::size_t const factor, double const pass, double const atten) :
+  _factor {factor} {
+  if (_factor < 2 || (_factor & (_factor - 1))) {
+    throw std::runtime_error("invalid factor '" + std::to_string(_factor) + "'");
+  }
+
+  // a stage with an input rate of 'rate' times the output rate has to keep
+  // the passband and stop from where its mirror image would fold onto it
+  for (std::size_t rate = _factor; rate > 1; rate /= 2) {
+    double const half {static_cast<double>(rate) / 2};
+    _stages.emplace_back((half - 2 * pass) / static_cast<double>(rate), atten);
+  }
+
+  // each stage reaches its taps at its own input rate, and every stage ahead
+  // of it has halved the rate once more
+  for (std::size_t i = 0, scale = 1; i < _stages.size(); ++i, scale *= 2) {
+    _reach += _stages[i].reach() * scale;
+  }
+}
+
+std::size_t Decimator::space(std::size_t const size) const {
+  std::size_t const length {_factor * (size - 1) + 2 * _reach + 1};
+  // the two phases of the first stage follow the input
+  return length + 2 * (length / 2 + 1);
+}
+
+void Decimator::decimate(double* out, double* in, std::size_t const size) const {
+  if (!size) {return;}
+  std::size_t length {_factor * (size - 1) + 2 * _reach + 1};
+  double* even {in + length};
+  double* odd {even + length / 2 + 1};
+  for (std::size_t i = 0; i < _stages.size(); ++i) {
+    // a stage splits its input into the two phases before writing, so its
+    // output can take the place of its input
+    length = (length - 2 * _stages[i].reach() - 1) / 2 + 1;
+    _stages[i].decimate(i + 1 == _stages.size() ? out : in, in, length, even, odd);
+  }
+}
+
+Resampler::Resampler(int const from, int const to, double const pass, double const atten) {
+  if (from <= 0 || to <= 0) {
+    throw std::runtime_error("invalid rate '" + std::to_string(from <= 0 ? from : to) + "'");
+  }
+  std::size_t const divisor {std::gcd(static_cast<std::size_t>(from), static_cast<std::size_t>(to))};
+  _up = static_cast<std::size_t>(to) / divisor;
+  _down = static_cast<std::size_t>(from) / divisor;
+  if (_up > phases) {
+    throw std::runtime_error("invalid rate '" + std::to_string(to) + "' from '" + std::to_string(from) + "'");
+  }
+
+  // the prototype runs at 'up' times the input rate, with its cutoff at the
+  // nyquist of the lower rate, the taps of each phase are padded to a
+  // multiple of 8 for the kernels
+  double const rate {static_cast<double>(_up) * from};
+  double const lower {static_cast<double>(std::min(from, to))};
+  double const cutoff {0.5 * lower / rate};
+  double const transition {(1 - 2 * pass) * lower / rate};
+  double const length {std::ceil((atten - 7.95) / (14.36 * transition)) + 1};
+  _taps = (static_cast<std::size_t>(std::ceil(length / static_cast<double>(_up))) + 7) / 8 * 8;
+
+  // the output sample with input index i and phase p reads the inputs from
+  // i - taps / 2 + 1, which sit at p + (taps / 2 - 1 - k) * up from it in
+  // prototype samples
+  double const beta {kaiser_beta(atten)};
+  double const half {static_cast<double>(_taps * _up) / 2};
+  _bank.resize(_up * _taps);
+  for (std::size_t p = 0; p < _up; ++p) {
+    double* const h {_bank.data() + p * _taps};
+    double sum {0};
+    for (std::size_t k = 0; k < _taps; ++k) {
+      double const d {static_cast<double>(p) + (static_cast<double>(_taps / 2) - 1 - static_cast<double>(k)) * static_cast<double>(_up)};
+      double const x {2 * cutoff * d};
+      double const sinc {x == 0 ? 1.0 : std::sin(M_PI * x) / (M_PI * x)};
+      double const r {d / half};
+      h[k] = r * r < 1 ? sinc * bessel_i0(beta * std::sqrt(1 - r * r)) : 0;
+      sum += h[k];
+    }
+    // unity gain at dc on every phase
+    for (std::size_t k = 0; k < _taps; ++k) {
+      h[k] /= sum;
+    }
+  }
+}
+
+std::size_t Resampler::first(std::size_t const frame) const {
+  // frame * down / up without overflowing
+  std::size_t const index {frame / _up * _down + frame % _up * _down / _up};
+  return index - (_taps / 2 - 1);
+}
+
+std::size_t Resampler::span(std::size_t const start, std::size_t const size) const {
+  if (!size) {return 0;}
+  return first(start + size - 1) - first(start) + _taps;
+}
+
+void Resampler::render(double* out, std::size_t const size, std::size_t const start, double const* in) const {
+  // phase of the first output sample in prototype samples past 'in'
+  std::size_t const phase {(start % _up) * _down % _up};
+  OB::Kernel::active().polyphase(out, size, in, _bank.data(), _taps, _up, _down, phase);
+}
+
+} // namespace OB::Filter
@@ -0,0 +1,180 @@
+/*
+                                    88888888
+                                  888888888888
+                                 88888888888888
+                                8888888888888888
+                               888888888888888888
+                              888888  8888  888888
+                              88888    88    88888
+                              888888  8888  888888
+                              88888888888888888888
+                              88888888888888888888
+                             8888888888888888888888
+                          8888888888888888888888888888
+                        88888888888888888888888888888888
+                              88888888888888888888
+                            888888888888888888888888
+                           888888  8888888888  888888
+                           888     8888  8888     888
+                                   888    888
+
+                                   OCTOBANANA
+
+Licensed under the MIT License
+
+Copyright (c) 2020 Brett Robinson <https://octobanana.com/>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef OB_FILTER_HH
+#define OB_FILTER_HH
+
+#include <cstddef>
+
+#include <vector>
+
+namespace OB::Filter {
+
+// Half-band lowpass FIR with its cutoff at a quarter of the input rate,
+// designed as a Kaiser windowed sinc with a transition band 'transition' of
+// the input rate wide and 'atten' dB of stopband attenuation. Apart from the
+// center, every other tap is zero and the rest are symmetric, so only the
+// odd taps on one side are kept.
+class Halfband {
+public:
+  Halfband(double const transition, double const atten);
+  Halfband(Halfband&&) = default;
+  Halfband(Halfband const&) = default;
+
+  ~Halfband() = default;
+
+  Halfband& operator=(Halfband&&) = default;
+  Halfband& operator=(Halfband const&) = default;
+
+  std::size_t taps() const {
+    return _taps.size();
+  }
+
+  // input samples on either side of the center of an output sample
+  std::size_t reach() const {
+    return 2 * _taps.size() - 1;
+  }
+
+  // halves the rate of the 2 * (size - 1) + 2 * reach() + 1 samples of 'in',
+  // out[i] is centered on in[2 * i + reach()], 'even' and 'odd' are scratch
+  // space for size + reach() samples each
+  void decimate(double* out, double const* in, std::size_t const size, double* even, double* odd) const;
+
+private:
+  std::vector<double> _taps;
+};
+
+// Lowers the rate by 'factor', a power of two, with a cascade of half-band
+// stages. The band up to 'pass' of the output rate is kept, and whatever
+// would alias into it is attenuated by 'atten' dB, the last stage carries the
+// narrow transition while the earlier ones get by with a few taps.
+class Decimator {
+public:
+  Decimator(std::size_t const factor, double const pass = 0.45, double const atten = 100.0);
+  Decimator(Decimator&&) = default;
+  Decimator(Decimator const&) = default;
+
+  ~Decimator() = default;
+
+  Decimator& operator=(Decimator&&) = default;
+  Decimator& operator=(Decimator const&) = default;
+
+  std::size_t factor() const {
+    return _factor;
+  }
+
+  // input samples on either side of the center of an output sample
+  std::size_t reach() const {
+    return _reach;
+  }
+
+  // samples of input and working space for 'size' samples of output
+  std::size_t space(std::size_t const size) const;
+
+  // lowers the rate of the factor() * (size - 1) + 2 * reach() + 1 samples at
+  // the start of 'in', out[i] is centered on in[factor() * i + reach()], the
+  // stages work in place so 'in' has to hold space(size) samples and is
+  // overwritten
+  void decimate(double* out, double* in, std::size_t const size) const;
+
+private:
+  std::size_t _factor {1};
+  std::size_t _reach {0};
+  std::vector<Halfband> _stages;
+};
+
+// Changes the rate from 'from' to 'to' Hz by the exact ratio up / down,
+// with a bank of 'up' Kaiser windowed sinc filters precomputed for every
+// phase an output sample can fall on. The band up to 'pass' of the lower of
+// the two rates is kept, and whatever would alias into it is attenuated by
+// 'atten' dB. Each output sample is a function of the input samples around
+// its own time alone.
+class Resampler {
+public:
+  // largest 'up' of a ratio, which bounds the size of the bank
+  static constexpr std::size_t phases {4096};
+
+  Resampler(int const from, int const to, double const pass = 0.45, double const atten = 100.0);
+  Resampler(Resampler&&) = default;
+  Resampler(Resampler const&) = default;
+
+  ~Resampler() = default;
+
+  Resampler& operator=(Resampler&&) = default;
+  Resampler& operator=(Resampler const&) = default;
+
+  std::size_t up() const {
+    return _up;
+  }
+
+  std::size_t down() const {
+    return _down;
+  }
+
+  // input samples each output sample is computed from
+  std::size_t taps() const {
+    return _taps;
+  }
+
+  // first input sample read for the output sample at 'frame', the ones of the
+  // first output samples lie before 0 and wrap around
+  std::size_t first(std::size_t const frame) const;
+
+  // input samples read for the output samples [start, start + size)
+  std::size_t span(std::size_t const start, std::size_t const size) const;
+
+  // renders the output samples [start, start + size) from 'in', which holds
+  // the input samples from first(start) on
+  void render(double* out, std::size_t const size, std::size_t const start, double const* in) const;
+
+private:
+  std::size_t _up {1};
+  std::size_t _down {1};
+  std::size_t _taps {0};
+  std::vector<double> _bank;
+};
+
+} // namespace OB::Filter
+
+#endif // OB_FILTER_HH
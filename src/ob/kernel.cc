@@ -0,0 +1,2071 @@
+/*
+                                    88888888
+                                  888888888888
+                                 88888888888888
+                                8888888888888888
+                               888888888888888888
+                              888888  8888  888888
+                              88888    88    88888
+                              888888  8888  888888
+                              88888888888888888888
+                              88888888888888888888
+                             8888888888888888888888
+                          8888888888888888888888888888
+                        88888888888888888888888888888888
+                              88888888888888888888
+                            888888888888888888888888
+                           888888  8888888888  888888
+                           888     8888  8888     888
+                                   888    888
+
+                                   OCTOBANANA
+
+Licensed under the MIT License
+
+Copyright (c) 2020 Brett Robinson <https://octobanana.com/>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "ob/kernel.hh"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <array>
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define OB_KERNEL_X86
+#define OB_KERNEL_TARGET(x) __attribute__((target(x)))
+#include <immintrin.h>
+#endif
+
+namespace OB::Kernel {
+
+// seeds 'lanes' consecutive rotations and returns the rotation by 'lanes' steps
+static void seed(double* lc, double* ls, std::size_t const lanes, double c, double s, double const dc, double const ds, double& wc, double& ws) {
+  wc = 1.0;
+  ws = 0.0;
+  for (std::size_t i = 0; i < lanes; ++i) {
+    lc[i] = c;
+    ls[i] = s;
+    double const t {c * dc - s * ds};
+    s = s * dc + c * ds;
+    c = t;
+    double const u {wc * dc - ws * ds};
+    ws = ws * dc + wc * ds;
+    wc = u;
+  }
+}
+
+static void sine_scalar(double* out, std::size_t const size, double c, double s, double const dc, double const ds) {
+  for (std::size_t i = 0; i < size; ++i) {
+    out[i] = s;
+    double const t {c * dc - s * ds};
+    s = s * dc + c * ds;
+    c = t;
+  }
+}
+
+// the triangle peaks a quarter cycle in, so shifting the phase by three
+// quarters centres its signed value on the peak
+static constexpr std::uint64_t triangle_offset {0xc000000000000000ull};
+
+static double signed_high(std::uint64_t const phase) {
+  return static_cast<double>(static_cast<std::int32_t>(static_cast<std::uint32_t>(phase >> 32)));
+}
+
+static void triangle_scalar(double* out, std::size_t const size, std::uint64_t phase, std::uint64_t const step) {
+  for (std::size_t i = 0; i < size; ++i) {
+    out[i] = 1.0 - std::fabs(signed_high(phase + triangle_offset)) * 0x1p-30;
+    phase += step;
+  }
+}
+
+static void square_scalar(double* out, std::size_t const size, std::uint64_t phase, std::uint64_t const step) {
+  for (std::size_t i = 0; i < size; ++i) {
+    out[i] = (phase >> 63) ? -1.0 : 1.0;
+    phase += step;
+  }
+}
+
+// the signed phase is a saw starting at zero in phase with the sine
+static void saw_scalar(double* out, std::size_t const size, std::uint64_t phase, std::uint64_t const step) {
+  for (std::size_t i = 0; i < size; ++i) {
+    out[i] = signed_high(phase) * 0x1p-31;
+    phase += step;
+  }
+}
+
+// odd minimax polynomial for sin(pi / 2 * t) on [-1, 1], max error 3.4e-9,
+// evaluated on the triangle which folds the phase onto that interval
+static constexpr double poly_c1 {0x1.921fb4a652ffbp+0};
+static constexpr double poly_c3 {-0x1.4abbb5a2139ebp-1};
+static constexpr double poly_c5 {0x1.46676d9c9f0cfp-4};
+static constexpr double poly_c7 {-0x1.3232fa2149b50p-8};
+static constexpr double poly_c9 {0x1.3c4b2c8e73ff9p-13};
+
+static double poly(double const t) {
+  double const t2 {t * t};
+  return t * (poly_c1 + t2 * (poly_c3 + t2 * (poly_c5 + t2 * (poly_c7 + t2 * poly_c9))));
+}
+
+static void sine_poly_scalar(double* out, std::size_t const size, std::uint64_t phase, std::uint64_t const step) {
+  for (std::size_t i = 0; i < size; ++i) {
+    out[i] = poly(1.0 - std::fabs(signed_high(phase + triangle_offset)) * 0x1p-30);
+    phase += step;
+  }
+}
+
+// one cycle of the sine indexed by the top 'lut_bits' of the phase with a
+// guard entry for the interpolation, linear interpolation between entries
+// bounds the error to (2 pi / 2^lut_bits)^2 / 8, about 1.2e-6
+static constexpr unsigned int lut_bits {11};
+static constexpr std::size_t lut_size {std::size_t {1} << lut_bits};
+
+// sin(2 pi k / lut_size) folded onto the first quarter cycle and summed as a
+// taylor series, libm is not usable in a constant expression
+static constexpr double lut_sine(std::size_t k) {
+  k %= lut_size;
+  bool const neg {k >= lut_size / 2};
+  if (neg) {k -= lut_size / 2;}
+  if (k > lut_size / 4) {k = lut_size / 2 - k;}
+  long double const x {2.0L * 3.14159265358979323846264338327950288L * static_cast<long double>(k) / static_cast<long double>(lut_size)};
+  long double sum {0};
+  long double term {x};
+  for (int n = 1; n < 40; n += 2) {
+    sum += term;
+    term *= -x * x / static_cast<long double>((n + 1) * (n + 2));
+  }
+  return static_cast<double>(neg ? -sum : sum);
+}
+
+static constexpr std::array<double, lut_size + 1> make_lut() {
+  std::array<double, lut_size + 1> lut {};
+  for (std::size_t i = 0; i < lut.size(); ++i) {
+    lut[i] = lut_sine(i);
+  }
+  return lut;
+}
+
+alignas(64) static constexpr std::array<double, lut_size + 1> lut {make_lut()};
+
+// the lookup kernels read a table of 2^Bits entries, the wavetables have
+// lookup_bits and the sine has lut_bits
+template<unsigned int Bits>
+static void lookup_scalar(double* out, std::size_t const size, double const* table, std::uint64_t phase, std::uint64_t const step) {
+  for (std::size_t i = 0; i < size; ++i) {
+    std::size_t const idx {static_cast<std::size_t>(phase >> (64 - Bits))};
+    double const frac {static_cast<double>((phase << Bits) >> 12) * 0x1p-52};
+    out[i] = table[idx] + (table[idx + 1] - table[idx]) * frac;
+    phase += step;
+  }
+}
+
+static void sine_table_scalar(double* out, std::size_t const size, std::uint64_t const phase, std::uint64_t const step) {
+  lookup_scalar<lut_bits>(out, size, lut.data(), phase, step);
+}
+
+static void partials_scalar(double* out, std::size_t const size, double const* sine, double const* cosine, double const* amps, std::size_t const count) {
+  for (std::size_t i = 0; i < size; ++i) {
+    double const twice {cosine[i] + cosine[i]};
+    double prev {0};
+    double cur {sine[i]};
+    double acc {amps[0] * cur};
+    for (std::size_t k = 1; k < count; ++k) {
+      double const next {twice * cur - prev};
+      prev = cur;
+      cur = next;
+      acc += amps[k] * cur;
+    }
+    out[i] = acc;
+  }
+}
+
+static void quantize_scalar(short* out, double const* in, std::size_t const size, double const gain) {
+  for (std::size_t i = 0; i < size; ++i) {
+    out[i] = static_cast<short>(std::clamp(in[i] * gain, -32768.0, 32767.0));
+  }
+}
+
+static void spread_scalar(short* out, short const* in, std::size_t const size, std::uint16_t const left, std::uint16_t const right) {
+  for (std::size_t i = 0; i < size; ++i) {
+    out[2 * i] = static_cast<short>(in[i] & left);
+    out[2 * i + 1] = static_cast<short>(in[i] & right);
+  }
+}
+
+static void round32_scalar(std::int32_t* out, double const* in, std::size_t const size, double const gain) {
+  for (std::size_t i = 0; i < size; ++i) {
+    out[i] = static_cast<std::int32_t>(std::nearbyint(std::clamp(in[i] * gain, -2147483648.0, 2147483647.0)));
+  }
+}
+
+static void narrow_scalar(float* out, double const* in, std::size_t const size, double const gain) {
+  for (std::size_t i = 0; i < size; ++i) {
+    out[i] = static_cast<float>(in[i] * gain);
+  }
+}
+
+static void spread32_scalar(std::uint32_t* out, std::uint32_t const* in, std::size_t const size, std::uint32_t const left, std::uint32_t const right) {
+  for (std::size_t i = 0; i < size; ++i) {
+    // float samples pass through here, so copy rather than read through the wrong type
+    std::uint32_t val;
+    std::memcpy(&val, in + i, sizeof(val));
+    val &= left;
+    std::memcpy(out + 2 * i, &val, sizeof(val));
+    std::memcpy(&val, in + i, sizeof(val));
+    val &= right;
+    std::memcpy(out + 2 * i + 1, &val, sizeof(val));
+  }
+}
+
+static void pack24_scalar(std::uint8_t* out, std::int32_t const* in, std::size_t const size) {
+  for (std::size_t i = 0; i < size; ++i) {
+    std::uint32_t const val {static_cast<std::uint32_t>(in[i])};
+    out[3 * i] = static_cast<std::uint8_t>(val);
+    out[3 * i + 1] = static_cast<std::uint8_t>(val >> 8);
+    out[3 * i + 2] = static_cast<std::uint8_t>(val >> 16);
+  }
+}
+
+// float and double samples pass through these as well, so each one is copied
+// rather than read through the wrong type
+template<typename W>
+static void interleave_scalar(W* out, W const* left, W const* right, std::size_t const size) {
+  for (std::size_t i = 0; i < size; ++i) {
+    std::memcpy(out + 2 * i, left + i, sizeof(W));
+    std::memcpy(out + 2 * i + 1, right + i, sizeof(W));
+  }
+}
+
+template<typename W>
+static void deinterleave_scalar(W* left, W* right, W const* in, std::size_t const size) {
+  for (std::size_t i = 0; i < size; ++i) {
+    std::memcpy(left + i, in + 2 * i, sizeof(W));
+    std::memcpy(right + i, in + 2 * i + 1, sizeof(W));
+  }
+}
+
+// lowbias32 integer hash by Chris Wellons, a bijection with low bias
+static std::uint32_t hash32(std::uint32_t x) {
+  x ^= x >> 16;
+  x *= 0x7feb352du;
+  x ^= x >> 15;
+  x *= 0x846ca68bu;
+  x ^= x >> 16;
+  return x;
+}
+
+// the two 16-bit halves of a hash are summed into a triangular distribution
+static constexpr double tpdf_scale {1.0 / 65536.0};
+
+static void tpdf_scalar(double* out, std::size_t const size, std::uint32_t const key, std::uint32_t const counter) {
+  for (std::size_t i = 0; i < size; ++i) {
+    std::uint32_t const h {hash32(static_cast<std::uint32_t>(counter + key + i))};
+    out[i] = static_cast<double>(static_cast<std::int32_t>((h & 0xffff) + (h >> 16)) - 65535) * tpdf_scale;
+  }
+}
+
+// a hash as a signed fraction in [-1, 1)
+static double unit(std::uint32_t const x) {
+  return static_cast<double>(static_cast<std::int32_t>(hash32(x))) * 0x1p-31;
+}
+
+static void noise_scalar(double* out, std::size_t const size, std::uint32_t const* keys, double const* weights, std::size_t const rows, std::uint32_t const counter, bool const ramp) {
+  for (std::size_t i = 0; i < size; ++i) {
+    std::uint32_t const frame {static_cast<std::uint32_t>(counter + i)};
+    double acc {0};
+    for (std::size_t k = 0; k < rows; ++k) {
+      std::uint32_t const idx {keys[k] + (frame >> k)};
+      double val {unit(idx)};
+      if (ramp && k) {
+        double const frac {static_cast<double>(static_cast<std::int32_t>(frame & ((std::uint32_t {1} << k) - 1))) * std::ldexp(1.0, -static_cast<int>(k))};
+        val = val + (unit(idx + 1) - val) * frac;
+      }
+      acc = acc + weights[k] * val;
+    }
+    out[i] = acc;
+  }
+}
+
+static void expand_scalar(double* out, std::size_t const size, double const* coarse, std::size_t const offset, bool const ramp) {
+  for (std::size_t i = 0; i < size; ++i) {
+    std::size_t const j {(offset + i) >> 2};
+    double val {coarse[j]};
+    if (ramp) {
+      val = val + (coarse[j + 1] - val) * (static_cast<double>((offset + i) & 3) * 0.25);
+    }
+    out[i] += val;
+  }
+}
+
+static void requantize_scalar(double* out, double const* in, double const* noise, std::size_t const size, double const gain, double const lo, double const hi) {
+  for (std::size_t i = 0; i < size; ++i) {
+    out[i] = std::nearbyint(std::clamp(in[i] * gain + noise[i], lo, hi));
+  }
+}
+
+// the outer taps are summed first, in the same order by every kernel
+static void halfband_scalar(double* out, double const* even, double const* odd, std::size_t const size, double const* taps, std::size_t const count) {
+  for (std::size_t i = 0; i < size; ++i) {
+    double acc {0};
+    for (std::size_t j = count; j-- > 0;) {
+      acc += taps[j] * (even[i + count - 1 - j] + even[i + count + j]);
+    }
+    out[i] = acc + 0.5 * odd[i + count - 1];
+  }
+}
+
+// every kernel keeps eight partial sums, of the products at k % 8, and adds
+// them up in this order
+static double reduce8(double const* sum) {
+  return ((sum[0] + sum[4]) + (sum[2] + sum[6])) + ((sum[1] + sum[5]) + (sum[3] + sum[7]));
+}
+
+static void polyphase_scalar(double* out, std::size_t const size, double const* in, double const* bank, std::size_t const taps, std::size_t const up, std::size_t const down, std::size_t phase) {
+  for (std::size_t i = 0; i < size; ++i) {
+    double const* x {in + phase / up};
+    double const* h {bank + (phase % up) * taps};
+    double sum[8] {};
+    for (std::size_t k = 0; k < taps; k += 8) {
+      for (std::size_t j = 0; j < 8; ++j) {
+        sum[j] += h[k + j] * x[k + j];
+      }
+    }
+    out[i] = reduce8(sum);
+    phase += down;
+  }
+}
+
+// adding and subtracting 1.5 * 2^52 rounds to an integer with ties to even,
+// as nearbyint does, for any value below 2^51
+static constexpr double round_magic {6755399441055744.0};
+
+// the low 32 bits of the rounded depth * mod[i] * 2^32 are the offset added
+// to the top 32 bits of the phase, the ones the sine is evaluated from
+static void modulate_scalar(double* out, std::size_t const size, double const* mod, double const depth, std::uint64_t phase, std::uint64_t const step) {
+  double const scale {depth * 0x1p32};
+  for (std::size_t i = 0; i < size; ++i) {
+    double const shift {mod[i] * scale + round_magic};
+    std::uint64_t bits;
+    std::memcpy(&bits, &shift, sizeof(bits));
+    out[i] = poly(1.0 - std::fabs(signed_high(phase + (bits << 32) + triangle_offset)) * 0x1p-30);
+    phase += step;
+  }
+}
+
+// each frame depends on the ones before it, every kernel table runs this one
+static void feedback_scalar(double* out, std::size_t const size, double const depth, std::uint64_t phase, std::uint64_t const step, double* last) {
+  // halving the scale is exact, it takes the mean of the two frames
+  double const scale {depth * 0x1p31};
+  double prev {last[0]};
+  double past {last[1]};
+  for (std::size_t i = 0; i < size; ++i) {
+    double const shift {(prev + past) * scale + round_magic};
+    std::uint64_t bits;
+    std::memcpy(&bits, &shift, sizeof(bits));
+    past = prev;
+    prev = poly(1.0 - std::fabs(signed_high(phase + (bits << 32) + triangle_offset)) * 0x1p-30);
+    out[i] = prev;
+    phase += step;
+  }
+  last[0] = prev;
+  last[1] = past;
+}
+
+// the four runs are stepped together so the latency of each feedback loop
+// overlaps the others
+static void shape_scalar(double* out, double const* in, double const* noise, std::size_t const size, std::size_t const stride, std::size_t const lead, double const* coefs, double const gain, double const lo, double const hi, double const limit) {
+  double e0[4] {}, e1[4] {}, e2[4] {}, e3[4] {}, e4[4] {};
+  for (std::size_t i = 0; i < size; ++i) {
+    for (std::size_t k = 0; k < 4; ++k) {
+      std::size_t const j {k * stride + i};
+      double const val {(in[j] * gain - (coefs[4] * e4[k] + coefs[3] * e3[k] + coefs[2] * e2[k] + coefs[1] * e1[k])) - coefs[0] * e0[k]};
+      double const step {(std::min(std::max(val + noise[j], lo), hi) + round_magic) - round_magic};
+      e4[k] = e3[k];
+      e3[k] = e2[k];
+      e2[k] = e1[k];
+      e1[k] = e0[k];
+      e0[k] = std::min(std::max(step - val, -limit), limit);
+      if (i >= lead) {out[j] = step;}
+    }
+  }
+}
+
+#ifdef OB_KERNEL_X86
+
+OB_KERNEL_TARGET("sse2")
+static void sine_sse2(double* out, std::size_t const size, double const c, double const s, double const dc, double const ds) {
+  double lc[2];
+  double ls[2];
+  double wc;
+  double ws;
+  seed(lc, ls, 2, c, s, dc, ds, wc, ws);
+  __m128d vc {_mm_loadu_pd(lc)};
+  __m128d vs {_mm_loadu_pd(ls)};
+  __m128d const vwc {_mm_set1_pd(wc)};
+  __m128d const vws {_mm_set1_pd(ws)};
+  std::size_t i {0};
+  for (; i + 2 <= size; i += 2) {
+    _mm_storeu_pd(out + i, vs);
+    __m128d const t {_mm_sub_pd(_mm_mul_pd(vc, vwc), _mm_mul_pd(vs, vws))};
+    vs = _mm_add_pd(_mm_mul_pd(vs, vwc), _mm_mul_pd(vc, vws));
+    vc = t;
+  }
+  if (i < size) {
+    _mm_storeu_pd(ls, vs);
+    out[i] = ls[0];
+  }
+}
+
+OB_KERNEL_TARGET("sse2")
+static void sine_poly_sse2(double* out, std::size_t const size, std::uint64_t const phase, std::uint64_t const step) {
+  std::uint64_t lp[2] {phase + triangle_offset, phase + triangle_offset + step};
+  __m128i vp {_mm_loadu_si128(reinterpret_cast<__m128i const*>(lp))};
+  __m128i const vstep {_mm_set1_epi64x(static_cast<long long>(2 * step))};
+  __m128d const one {_mm_set1_pd(1.0)};
+  __m128d const scale {_mm_set1_pd(0x1p-30)};
+  __m128d const sign {_mm_set1_pd(-0.0)};
+  std::size_t i {0};
+  for (; i + 2 <= size; i += 2) {
+    __m128d const v {_mm_cvtepi32_pd(_mm_shuffle_epi32(vp, _MM_SHUFFLE(3, 3, 3, 1)))};
+    __m128d const t {_mm_sub_pd(one, _mm_mul_pd(_mm_andnot_pd(sign, v), scale))};
+    __m128d const t2 {_mm_mul_pd(t, t)};
+    __m128d p {_mm_set1_pd(poly_c9)};
+    p = _mm_add_pd(_mm_mul_pd(p, t2), _mm_set1_pd(poly_c7));
+    p = _mm_add_pd(_mm_mul_pd(p, t2), _mm_set1_pd(poly_c5));
+    p = _mm_add_pd(_mm_mul_pd(p, t2), _mm_set1_pd(poly_c3));
+    p = _mm_add_pd(_mm_mul_pd(p, t2), _mm_set1_pd(poly_c1));
+    _mm_storeu_pd(out + i, _mm_mul_pd(p, t));
+    vp = _mm_add_epi64(vp, vstep);
+  }
+  if (i < size) {
+    sine_poly_scalar(out + i, size - i, phase + i * step, step);
+  }
+}
+
+OB_KERNEL_TARGET("sse2")
+static void modulate_sse2(double* out, std::size_t const size, double const* mod, double const depth, std::uint64_t const phase, std::uint64_t const step) {
+  std::uint64_t lp[2] {phase + triangle_offset, phase + triangle_offset + step};
+  __m128i vp {_mm_loadu_si128(reinterpret_cast<__m128i const*>(lp))};
+  __m128i const vstep {_mm_set1_epi64x(static_cast<long long>(2 * step))};
+  __m128d const vscale {_mm_set1_pd(depth * 0x1p32)};
+  __m128d const magic {_mm_set1_pd(round_magic)};
+  __m128d const one {_mm_set1_pd(1.0)};
+  __m128d const scale {_mm_set1_pd(0x1p-30)};
+  __m128d const sign {_mm_set1_pd(-0.0)};
+  std::size_t i {0};
+  for (; i + 2 <= size; i += 2) {
+    __m128i const shift {_mm_slli_epi64(_mm_castpd_si128(_mm_add_pd(_mm_mul_pd(_mm_loadu_pd(mod + i), vscale), magic)), 32)};
+    __m128d const v {_mm_cvtepi32_pd(_mm_shuffle_epi32(_mm_add_epi64(vp, shift), _MM_SHUFFLE(3, 3, 3, 1)))};
+    __m128d const t {_mm_sub_pd(one, _mm_mul_pd(_mm_andnot_pd(sign, v), scale))};
+    __m128d const t2 {_mm_mul_pd(t, t)};
+    __m128d p {_mm_set1_pd(poly_c9)};
+    p = _mm_add_pd(_mm_mul_pd(p, t2), _mm_set1_pd(poly_c7));
+    p = _mm_add_pd(_mm_mul_pd(p, t2), _mm_set1_pd(poly_c5));
+    p = _mm_add_pd(_mm_mul_pd(p, t2), _mm_set1_pd(poly_c3));
+    p = _mm_add_pd(_mm_mul_pd(p, t2), _mm_set1_pd(poly_c1));
+    _mm_storeu_pd(out + i, _mm_mul_pd(p, t));
+    vp = _mm_add_epi64(vp, vstep);
+  }
+  if (i < size) {
+    modulate_scalar(out + i, size - i, mod + i, depth, phase + i * step, step);
+  }
+}
+
+OB_KERNEL_TARGET("sse2")
+static void square_sse2(double* out, std::size_t const size, std::uint64_t const phase, std::uint64_t const step) {
+  std::uint64_t lp[2] {phase, phase + step};
+  __m128i vp {_mm_loadu_si128(reinterpret_cast<__m128i const*>(lp))};
+  __m128i const vstep {_mm_set1_epi64x(static_cast<long long>(2 * step))};
+  __m128i const sign {_mm_castpd_si128(_mm_set1_pd(-0.0))};
+  __m128i const one {_mm_castpd_si128(_mm_set1_pd(1.0))};
+  std::size_t i {0};
+  for (; i + 2 <= size; i += 2) {
+    _mm_storeu_pd(out + i, _mm_castsi128_pd(_mm_or_si128(one, _mm_and_si128(vp, sign))));
+    vp = _mm_add_epi64(vp, vstep);
+  }
+  if (i < size) {
+    square_scalar(out + i, size - i, phase + i * step, step);
+  }
+}
+
+OB_KERNEL_TARGET("sse2")
+static void triangle_sse2(double* out, std::size_t const size, std::uint64_t const phase, std::uint64_t const step) {
+  std::uint64_t lp[2] {phase + triangle_offset, phase + triangle_offset + step};
+  __m128i vp {_mm_loadu_si128(reinterpret_cast<__m128i const*>(lp))};
+  __m128i const vstep {_mm_set1_epi64x(static_cast<long long>(2 * step))};
+  __m128d const one {_mm_set1_pd(1.0)};
+  __m128d const scale {_mm_set1_pd(0x1p-30)};
+  __m128d const sign {_mm_set1_pd(-0.0)};
+  std::size_t i {0};
+  for (; i + 2 <= size; i += 2) {
+    __m128d const v {_mm_cvtepi32_pd(_mm_shuffle_epi32(vp, _MM_SHUFFLE(3, 3, 3, 1)))};
+    _mm_storeu_pd(out + i, _mm_sub_pd(one, _mm_mul_pd(_mm_andnot_pd(sign, v), scale)));
+    vp = _mm_add_epi64(vp, vstep);
+  }
+  if (i < size) {
+    triangle_scalar(out + i, size - i, phase + i * step, step);
+  }
+}
+
+OB_KERNEL_TARGET("sse2")
+static void saw_sse2(double* out, std::size_t const size, std::uint64_t const phase, std::uint64_t const step) {
+  std::uint64_t lp[2] {phase, phase + step};
+  __m128i vp {_mm_loadu_si128(reinterpret_cast<__m128i const*>(lp))};
+  __m128i const vstep {_mm_set1_epi64x(static_cast<long long>(2 * step))};
+  __m128d const scale {_mm_set1_pd(0x1p-31)};
+  std::size_t i {0};
+  for (; i + 2 <= size; i += 2) {
+    _mm_storeu_pd(out + i, _mm_mul_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(vp, _MM_SHUFFLE(3, 3, 3, 1))), scale));
+    vp = _mm_add_epi64(vp, vstep);
+  }
+  if (i < size) {
+    saw_scalar(out + i, size - i, phase + i * step, step);
+  }
+}
+
+OB_KERNEL_TARGET("sse2")
+static void quantize_sse2(short* out, double const* in, std::size_t const size, double const gain) {
+  __m128d const vgain {_mm_set1_pd(gain)};
+  __m128d const lo {_mm_set1_pd(-32768.0)};
+  __m128d const hi {_mm_set1_pd(32767.0)};
+  std::size_t i {0};
+  for (; i + 8 <= size; i += 8) {
+    __m128i v[4];
+    for (std::size_t j = 0; j < 4; ++j) {
+      v[j] = _mm_cvttpd_epi32(_mm_min_pd(_mm_max_pd(_mm_mul_pd(_mm_loadu_pd(in + i + 2 * j), vgain), lo), hi));
+    }
+    __m128i const a {_mm_unpacklo_epi64(v[0], v[1])};
+    __m128i const b {_mm_unpacklo_epi64(v[2], v[3])};
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(a, b));
+  }
+  quantize_scalar(out + i, in + i, size - i, gain);
+}
+
+OB_KERNEL_TARGET("sse2")
+static void spread_sse2(short* out, short const* in, std::size_t const size, std::uint16_t const left, std::uint16_t const right) {
+  __m128i const mask {_mm_set1_epi32(static_cast<int>(left | (static_cast<std::uint32_t>(right) << 16)))};
+  std::size_t i {0};
+  for (; i + 8 <= size; i += 8) {
+    __m128i const v {_mm_loadu_si128(reinterpret_cast<__m128i const*>(in + i))};
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i), _mm_and_si128(_mm_unpacklo_epi16(v, v), mask));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i + 8), _mm_and_si128(_mm_unpackhi_epi16(v, v), mask));
+  }
+  spread_scalar(out + 2 * i, in + i, size - i, left, right);
+}
+
+OB_KERNEL_TARGET("sse2")
+static void round32_sse2(std::int32_t* out, double const* in, std::size_t const size, double const gain) {
+  __m128d const vgain {_mm_set1_pd(gain)};
+  __m128d const lo {_mm_set1_pd(-2147483648.0)};
+  __m128d const hi {_mm_set1_pd(2147483647.0)};
+  std::size_t i {0};
+  for (; i + 4 <= size; i += 4) {
+    __m128i const a {_mm_cvtpd_epi32(_mm_min_pd(_mm_max_pd(_mm_mul_pd(_mm_loadu_pd(in + i), vgain), lo), hi))};
+    __m128i const b {_mm_cvtpd_epi32(_mm_min_pd(_mm_max_pd(_mm_mul_pd(_mm_loadu_pd(in + i + 2), vgain), lo), hi))};
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_unpacklo_epi64(a, b));
+  }
+  round32_scalar(out + i, in + i, size - i, gain);
+}
+
+OB_KERNEL_TARGET("sse2")
+static void narrow_sse2(float* out, double const* in, std::size_t const size, double const gain) {
+  __m128d const vgain {_mm_set1_pd(gain)};
+  std::size_t i {0};
+  for (; i + 4 <= size; i += 4) {
+    __m128 const a {_mm_cvtpd_ps(_mm_mul_pd(_mm_loadu_pd(in + i), vgain))};
+    __m128 const b {_mm_cvtpd_ps(_mm_mul_pd(_mm_loadu_pd(in + i + 2), vgain))};
+    _mm_storeu_ps(out + i, _mm_movelh_ps(a, b));
+  }
+  narrow_scalar(out + i, in + i, size - i, gain);
+}
+
+OB_KERNEL_TARGET("sse2")
+static void spread32_sse2(std::uint32_t* out, std::uint32_t const* in, std::size_t const size, std::uint32_t const left, std::uint32_t const right) {
+  __m128i const mask {_mm_set_epi32(static_cast<int>(right), static_cast<int>(left), static_cast<int>(right), static_cast<int>(left))};
+  std::size_t i {0};
+  for (; i + 4 <= size; i += 4) {
+    __m128i const v {_mm_loadu_si128(reinterpret_cast<__m128i const*>(in + i))};
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i), _mm_and_si128(_mm_unpacklo_epi32(v, v), mask));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i + 4), _mm_and_si128(_mm_unpackhi_epi32(v, v), mask));
+  }
+  spread32_scalar(out + 2 * i, in + i, size - i, left, right);
+}
+
+OB_KERNEL_TARGET("sse2")
+static void interleave16_sse2(std::uint16_t* out, std::uint16_t const* left, std::uint16_t const* right, std::size_t const size) {
+  std::size_t i {0};
+  for (; i + 8 <= size; i += 8) {
+    __m128i const l {_mm_loadu_si128(reinterpret_cast<__m128i const*>(left + i))};
+    __m128i const r {_mm_loadu_si128(reinterpret_cast<__m128i const*>(right + i))};
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i), _mm_unpacklo_epi16(l, r));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i + 8), _mm_unpackhi_epi16(l, r));
+  }
+  interleave_scalar(out + 2 * i, left + i, right + i, size - i);
+}
+
+OB_KERNEL_TARGET("sse2")
+static void interleave32_sse2(std::uint32_t* out, std::uint32_t const* left, std::uint32_t const* right, std::size_t const size) {
+  std::size_t i {0};
+  for (; i + 4 <= size; i += 4) {
+    __m128i const l {_mm_loadu_si128(reinterpret_cast<__m128i const*>(left + i))};
+    __m128i const r {_mm_loadu_si128(reinterpret_cast<__m128i const*>(right + i))};
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i), _mm_unpacklo_epi32(l, r));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i + 4), _mm_unpackhi_epi32(l, r));
+  }
+  interleave_scalar(out + 2 * i, left + i, right + i, size - i);
+}
+
+OB_KERNEL_TARGET("sse2")
+static void interleave64_sse2(std::uint64_t* out, std::uint64_t const* left, std::uint64_t const* right, std::size_t const size) {
+  std::size_t i {0};
+  for (; i + 2 <= size; i += 2) {
+    __m128i const l {_mm_loadu_si128(reinterpret_cast<__m128i const*>(left + i))};
+    __m128i const r {_mm_loadu_si128(reinterpret_cast<__m128i const*>(right + i))};
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i), _mm_unpacklo_epi64(l, r));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i + 2), _mm_unpackhi_epi64(l, r));
+  }
+  interleave_scalar(out + 2 * i, left + i, right + i, size - i);
+}
+
+// each vector is gathered into its left half and right half, then the halves
+// of two vectors are joined
+OB_KERNEL_TARGET("sse2")
+static __m128i split16_sse2(__m128i const v) {
+  return _mm_shuffle_epi32(_mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xd8), 0xd8), 0xd8);
+}
+
+OB_KERNEL_TARGET("sse2")
+static void deinterleave16_sse2(std::uint16_t* left, std::uint16_t* right, std::uint16_t const* in, std::size_t const size) {
+  std::size_t i {0};
+  for (; i + 8 <= size; i += 8) {
+    __m128i const a {split16_sse2(_mm_loadu_si128(reinterpret_cast<__m128i const*>(in + 2 * i)))};
+    __m128i const b {split16_sse2(_mm_loadu_si128(reinterpret_cast<__m128i const*>(in + 2 * i + 8)))};
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(left + i), _mm_unpacklo_epi64(a, b));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(right + i), _mm_unpackhi_epi64(a, b));
+  }
+  deinterleave_scalar(left + i, right + i, in + 2 * i, size - i);
+}
+
+OB_KERNEL_TARGET("sse2")
+static void deinterleave32_sse2(std::uint32_t* left, std::uint32_t* right, std::uint32_t const* in, std::size_t const size) {
+  std::size_t i {0};
+  for (; i + 4 <= size; i += 4) {
+    __m128i const a {_mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(in + 2 * i)), 0xd8)};
+    __m128i const b {_mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(in + 2 * i + 4)), 0xd8)};
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(left + i), _mm_unpacklo_epi64(a, b));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(right + i), _mm_unpackhi_epi64(a, b));
+  }
+  deinterleave_scalar(left + i, right + i, in + 2 * i, size - i);
+}
+
+OB_KERNEL_TARGET("sse2")
+static void deinterleave64_sse2(std::uint64_t* left, std::uint64_t* right, std::uint64_t const* in, std::size_t const size) {
+  std::size_t i {0};
+  for (; i + 2 <= size; i += 2) {
+    __m128i const a {_mm_loadu_si128(reinterpret_cast<__m128i const*>(in + 2 * i))};
+    __m128i const b {_mm_loadu_si128(reinterpret_cast<__m128i const*>(in + 2 * i + 2))};
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(left + i), _mm_unpacklo_epi64(a, b));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(right + i), _mm_unpackhi_epi64(a, b));
+  }
+  deinterleave_scalar(left + i, right + i, in + 2 * i, size - i);
+}
+
+// sse2 has no 32-bit multiply, the even and odd lanes are multiplied apart
+OB_KERNEL_TARGET("sse2")
+static __m128i mullo32_sse2(__m128i const a, __m128i const b) {
+  __m128i const even {_mm_mul_epu32(a, b)};
+  __m128i const odd {_mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32))};
+  return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, 0x08), _mm_shuffle_epi32(odd, 0x08));
+}
+
+OB_KERNEL_TARGET("sse2")
+static void tpdf_sse2(double* out, std::size_t const size, std::uint32_t const key, std::uint32_t const counter) {
+  __m128i const step {_mm_set1_epi32(4)};
+  __m128i const m1 {_mm_set1_epi32(0x7feb352d)};
+  __m128i const m2 {_mm_set1_epi32(static_cast<int>(0x846ca68bu))};
+  __m128i const low {_mm_set1_epi32(0xffff)};
+  __m128i const bias {_mm_set1_epi32(65535)};
+  __m128d const scale {_mm_set1_pd(tpdf_scale)};
+  __m128i x {_mm_add_epi32(_mm_set1_epi32(static_cast<int>(counter + key)), _mm_setr_epi32(0, 1, 2, 3))};
+  std::size_t i {0};
+  for (; i + 4 <= size; i += 4) {
+    __m128i h {_mm_xor_si128(x, _mm_srli_epi32(x, 16))};
+    h = mullo32_sse2(h, m1);
+    h = _mm_xor_si128(h, _mm_srli_epi32(h, 15));
+    h = mullo32_sse2(h, m2);
+    h = _mm_xor_si128(h, _mm_srli_epi32(h, 16));
+    __m128i const s {_mm_sub_epi32(_mm_add_epi32(_mm_and_si128(h, low), _mm_srli_epi32(h, 16)), bias)};
+    _mm_storeu_pd(out + i, _mm_mul_pd(_mm_cvtepi32_pd(s), scale));
+    _mm_storeu_pd(out + i + 2, _mm_mul_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(s, 0xee)), scale));
+    x = _mm_add_epi32(x, step);
+  }
+  tpdf_scalar(out + i, size - i, key, static_cast<std::uint32_t>(counter + i));
+}
+
+OB_KERNEL_TARGET("sse2")
+static __m128i hash32_sse2(__m128i x) {
+  x = _mm_xor_si128(x, _mm_srli_epi32(x, 16));
+  x = mullo32_sse2(x, _mm_set1_epi32(0x7feb352d));
+  x = _mm_xor_si128(x, _mm_srli_epi32(x, 15));
+  x = mullo32_sse2(x, _mm_set1_epi32(static_cast<int>(0x846ca68bu)));
+  return _mm_xor_si128(x, _mm_srli_epi32(x, 16));
+}
+
+OB_KERNEL_TARGET("sse2")
+static void noise_sse2(double* out, std::size_t const size, std::uint32_t const* keys, double const* weights, std::size_t const rows, std::uint32_t const counter, bool const ramp) {
+  __m128i const one {_mm_set1_epi32(1)};
+  __m128d const scale {_mm_set1_pd(0x1p-31)};
+  __m128i frame {_mm_add_epi32(_mm_set1_epi32(static_cast<int>(counter)), _mm_setr_epi32(0, 1, 2, 3))};
+  std::size_t i {0};
+  for (; i + 4 <= size; i += 4) {
+    __m128d lo {_mm_setzero_pd()};
+    __m128d hi {_mm_setzero_pd()};
+    for (std::size_t k = 0; k < rows; ++k) {
+      __m128i const idx {_mm_add_epi32(_mm_set1_epi32(static_cast<int>(keys[k])), _mm_srl_epi32(frame, _mm_cvtsi32_si128(static_cast<int>(k))))};
+      __m128i const h {hash32_sse2(idx)};
+      __m128d vlo {_mm_mul_pd(_mm_cvtepi32_pd(h), scale)};
+      __m128d vhi {_mm_mul_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(h, 0xee)), scale)};
+      if (ramp && k) {
+        __m128i const next {hash32_sse2(_mm_add_epi32(idx, one))};
+        __m128i const part {_mm_and_si128(frame, _mm_set1_epi32(static_cast<int>((std::uint32_t {1} << k) - 1)))};
+        __m128d const step {_mm_set1_pd(std::ldexp(1.0, -static_cast<int>(k)))};
+        vlo = _mm_add_pd(vlo, _mm_mul_pd(_mm_sub_pd(_mm_mul_pd(_mm_cvtepi32_pd(next), scale), vlo), _mm_mul_pd(_mm_cvtepi32_pd(part), step)));
+        vhi = _mm_add_pd(vhi, _mm_mul_pd(_mm_sub_pd(_mm_mul_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(next, 0xee)), scale), vhi), _mm_mul_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(part, 0xee)), step)));
+      }
+      __m128d const weight {_mm_set1_pd(weights[k])};
+      lo = _mm_add_pd(lo, _mm_mul_pd(weight, vlo));
+      hi = _mm_add_pd(hi, _mm_mul_pd(weight, vhi));
+    }
+    _mm_storeu_pd(out + i, lo);
+    _mm_storeu_pd(out + i + 2, hi);
+    frame = _mm_add_epi32(frame, _mm_set1_epi32(4));
+  }
+  noise_scalar(out + i, size - i, keys, weights, rows, static_cast<std::uint32_t>(counter + i), ramp);
+}
+
+// the frames up to the first whole step of the grid are taken on their own,
+// as are those past the last
+OB_KERNEL_TARGET("sse2")
+static void expand_sse2(double* out, std::size_t const size, double const* coarse, std::size_t const offset, bool const ramp) {
+  std::size_t i {std::min(size, (4 - (offset & 3)) & 3)};
+  expand_scalar(out, i, coarse, offset, ramp);
+  __m128d const frac0 {_mm_setr_pd(0.0, 0.25)};
+  __m128d const frac1 {_mm_setr_pd(0.5, 0.75)};
+  for (std::size_t j = (offset + i) >> 2; i + 4 <= size; i += 4, ++j) {
+    __m128d const val {_mm_set1_pd(coarse[j])};
+    __m128d v0 {val};
+    __m128d v1 {val};
+    if (ramp) {
+      __m128d const slope {_mm_sub_pd(_mm_set1_pd(coarse[j + 1]), val)};
+      v0 = _mm_add_pd(val, _mm_mul_pd(slope, frac0));
+      v1 = _mm_add_pd(val, _mm_mul_pd(slope, frac1));
+    }
+    _mm_storeu_pd(out + i, _mm_add_pd(_mm_loadu_pd(out + i), v0));
+    _mm_storeu_pd(out + i + 2, _mm_add_pd(_mm_loadu_pd(out + i + 2), v1));
+  }
+  expand_scalar(out + i, size - i, coarse + ((offset + i) >> 2), 0, ramp);
+}
+
+OB_KERNEL_TARGET("sse2")
+static void requantize_sse2(double* out, double const* in, double const* noise, std::size_t const size, double const gain, double const lo, double const hi) {
+  __m128d const vgain {_mm_set1_pd(gain)};
+  __m128d const vlo {_mm_set1_pd(lo)};
+  __m128d const vhi {_mm_set1_pd(hi)};
+  __m128d const magic {_mm_set1_pd(round_magic)};
+  std::size_t i {0};
+  for (; i + 2 <= size; i += 2) {
+    __m128d const v {_mm_min_pd(_mm_max_pd(_mm_add_pd(_mm_mul_pd(_mm_loadu_pd(in + i), vgain), _mm_loadu_pd(noise + i)), vlo), vhi)};
+    _mm_storeu_pd(out + i, _mm_sub_pd(_mm_add_pd(v, magic), magic));
+  }
+  requantize_scalar(out + i, in + i, noise + i, size - i, gain, lo, hi);
+}
+
+// runs 0 and 1 share one register, runs 2 and 3 the other
+OB_KERNEL_TARGET("sse2")
+static void shape_sse2(double* out, double const* in, double const* noise, std::size_t const size, std::size_t const stride, std::size_t const lead, double const* coefs, double const gain, double const lo, double const hi, double const limit) {
+  __m128d const c0 {_mm_set1_pd(coefs[0])};
+  __m128d const c1 {_mm_set1_pd(coefs[1])};
+  __m128d const c2 {_mm_set1_pd(coefs[2])};
+  __m128d const c3 {_mm_set1_pd(coefs[3])};
+  __m128d const c4 {_mm_set1_pd(coefs[4])};
+  __m128d const vgain {_mm_set1_pd(gain)};
+  __m128d const vlo {_mm_set1_pd(lo)};
+  __m128d const vhi {_mm_set1_pd(hi)};
+  __m128d const vmax {_mm_set1_pd(limit)};
+  __m128d const vmin {_mm_set1_pd(-limit)};
+  __m128d const magic {_mm_set1_pd(round_magic)};
+  __m128d e0[2] {_mm_setzero_pd(), _mm_setzero_pd()};
+  __m128d e1[2] {e0[0], e0[0]};
+  __m128d e2[2] {e0[0], e0[0]};
+  __m128d e3[2] {e0[0], e0[0]};
+  __m128d e4[2] {e0[0], e0[0]};
+  for (std::size_t i = 0; i < size; ++i) {
+    for (std::size_t k = 0; k < 2; ++k) {
+      std::size_t const j {2 * k * stride + i};
+      __m128d const x {_mm_loadh_pd(_mm_load_sd(in + j), in + j + stride)};
+      __m128d const n {_mm_loadh_pd(_mm_load_sd(noise + j), noise + j + stride)};
+      __m128d const rest {_mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(c4, e4[k]), _mm_mul_pd(c3, e3[k])), _mm_mul_pd(c2, e2[k])), _mm_mul_pd(c1, e1[k]))};
+      __m128d const val {_mm_sub_pd(_mm_sub_pd(_mm_mul_pd(x, vgain), rest), _mm_mul_pd(c0, e0[k]))};
+      __m128d const step {_mm_sub_pd(_mm_add_pd(_mm_min_pd(_mm_max_pd(_mm_add_pd(val, n), vlo), vhi), magic), magic)};
+      e4[k] = e3[k];
+      e3[k] = e2[k];
+      e2[k] = e1[k];
+      e1[k] = e0[k];
+      e0[k] = _mm_min_pd(_mm_max_pd(_mm_sub_pd(step, val), vmin), vmax);
+      if (i >= lead) {
+        _mm_storel_pd(out + j, step);
+        _mm_storeh_pd(out + j + stride, step);
+      }
+    }
+  }
+}
+
+OB_KERNEL_TARGET("sse2")
+static void partials_sse2(double* out, std::size_t const size, double const* sine, double const* cosine, double const* amps, std::size_t const count) {
+  std::size_t i {0};
+  // four independent recurrences hide the latency of each step
+  for (; i + 8 <= size; i += 8) {
+    __m128d const c0 {_mm_loadu_pd(cosine + i)};
+    __m128d const c1 {_mm_loadu_pd(cosine + i + 2)};
+    __m128d const c2 {_mm_loadu_pd(cosine + i + 4)};
+    __m128d const c3 {_mm_loadu_pd(cosine + i + 6)};
+    __m128d const twice0 {_mm_add_pd(c0, c0)};
+    __m128d const twice1 {_mm_add_pd(c1, c1)};
+    __m128d const twice2 {_mm_add_pd(c2, c2)};
+    __m128d const twice3 {_mm_add_pd(c3, c3)};
+    __m128d prev0 {_mm_setzero_pd()};
+    __m128d prev1 {_mm_setzero_pd()};
+    __m128d prev2 {_mm_setzero_pd()};
+    __m128d prev3 {_mm_setzero_pd()};
+    __m128d cur0 {_mm_loadu_pd(sine + i)};
+    __m128d cur1 {_mm_loadu_pd(sine + i + 2)};
+    __m128d cur2 {_mm_loadu_pd(sine + i + 4)};
+    __m128d cur3 {_mm_loadu_pd(sine + i + 6)};
+    __m128d const amp {_mm_set1_pd(amps[0])};
+    __m128d acc0 {_mm_mul_pd(amp, cur0)};
+    __m128d acc1 {_mm_mul_pd(amp, cur1)};
+    __m128d acc2 {_mm_mul_pd(amp, cur2)};
+    __m128d acc3 {_mm_mul_pd(amp, cur3)};
+    for (std::size_t k = 1; k < count; ++k) {
+      __m128d const gain {_mm_set1_pd(amps[k])};
+      __m128d const next0 {_mm_sub_pd(_mm_mul_pd(twice0, cur0), prev0)};
+      __m128d const next1 {_mm_sub_pd(_mm_mul_pd(twice1, cur1), prev1)};
+      __m128d const next2 {_mm_sub_pd(_mm_mul_pd(twice2, cur2), prev2)};
+      __m128d const next3 {_mm_sub_pd(_mm_mul_pd(twice3, cur3), prev3)};
+      prev0 = cur0;
+      prev1 = cur1;
+      prev2 = cur2;
+      prev3 = cur3;
+      cur0 = next0;
+      cur1 = next1;
+      cur2 = next2;
+      cur3 = next3;
+      acc0 = _mm_add_pd(acc0, _mm_mul_pd(gain, cur0));
+      acc1 = _mm_add_pd(acc1, _mm_mul_pd(gain, cur1));
+      acc2 = _mm_add_pd(acc2, _mm_mul_pd(gain, cur2));
+      acc3 = _mm_add_pd(acc3, _mm_mul_pd(gain, cur3));
+    }
+    _mm_storeu_pd(out + i, acc0);
+    _mm_storeu_pd(out + i + 2, acc1);
+    _mm_storeu_pd(out + i + 4, acc2);
+    _mm_storeu_pd(out + i + 6, acc3);
+  }
+  partials_scalar(out + i, size - i, sine + i, cosine + i, amps, count);
+}
+
+OB_KERNEL_TARGET("sse2")
+static void halfband_sse2(double* out, double const* even, double const* odd, std::size_t const size, double const* taps, std::size_t const count) {
+  __m128d const half {_mm_set1_pd(0.5)};
+  std::size_t i {0};
+  // four independent sums hide the latency of the adds
+  for (; i + 8 <= size; i += 8) {
+    double const* lo {even + i + count - 1};
+    double const* hi {even + i + count};
+    __m128d acc0 {_mm_setzero_pd()};
+    __m128d acc1 {_mm_setzero_pd()};
+    __m128d acc2 {_mm_setzero_pd()};
+    __m128d acc3 {_mm_setzero_pd()};
+    for (std::size_t j = count; j-- > 0;) {
+      __m128d const tap {_mm_set1_pd(taps[j])};
+      acc0 = _mm_add_pd(acc0, _mm_mul_pd(tap, _mm_add_pd(_mm_loadu_pd(lo - j), _mm_loadu_pd(hi + j))));
+      acc1 = _mm_add_pd(acc1, _mm_mul_pd(tap, _mm_add_pd(_mm_loadu_pd(lo - j + 2), _mm_loadu_pd(hi + j + 2))));
+      acc2 = _mm_add_pd(acc2, _mm_mul_pd(tap, _mm_add_pd(_mm_loadu_pd(lo - j + 4), _mm_loadu_pd(hi + j + 4))));
+      acc3 = _mm_add_pd(acc3, _mm_mul_pd(tap, _mm_add_pd(_mm_loadu_pd(lo - j + 6), _mm_loadu_pd(hi + j + 6))));
+    }
+    double const* mid {odd + i + count - 1};
+    _mm_storeu_pd(out + i, _mm_add_pd(acc0, _mm_mul_pd(half, _mm_loadu_pd(mid))));
+    _mm_storeu_pd(out + i + 2, _mm_add_pd(acc1, _mm_mul_pd(half, _mm_loadu_pd(mid + 2))));
+    _mm_storeu_pd(out + i + 4, _mm_add_pd(acc2, _mm_mul_pd(half, _mm_loadu_pd(mid + 4))));
+    _mm_storeu_pd(out + i + 6, _mm_add_pd(acc3, _mm_mul_pd(half, _mm_loadu_pd(mid + 6))));
+  }
+  halfband_scalar(out + i, even + i, odd + i, size - i, taps, count);
+}
+
+OB_KERNEL_TARGET("sse2")
+static void polyphase_sse2(double* out, std::size_t const size, double const* in, double const* bank, std::size_t const taps, std::size_t const up, std::size_t const down, std::size_t phase) {
+  for (std::size_t i = 0; i < size; ++i) {
+    double const* x {in + phase / up};
+    double const* h {bank + (phase % up) * taps};
+    __m128d s0 {_mm_setzero_pd()};
+    __m128d s1 {_mm_setzero_pd()};
+    __m128d s2 {_mm_setzero_pd()};
+    __m128d s3 {_mm_setzero_pd()};
+    for (std::size_t k = 0; k < taps; k += 8) {
+      s0 = _mm_add_pd(s0, _mm_mul_pd(_mm_loadu_pd(h + k), _mm_loadu_pd(x + k)));
+      s1 = _mm_add_pd(s1, _mm_mul_pd(_mm_loadu_pd(h + k + 2), _mm_loadu_pd(x + k + 2)));
+      s2 = _mm_add_pd(s2, _mm_mul_pd(_mm_loadu_pd(h + k + 4), _mm_loadu_pd(x + k + 4)));
+      s3 = _mm_add_pd(s3, _mm_mul_pd(_mm_loadu_pd(h + k + 6), _mm_loadu_pd(x + k + 6)));
+    }
+    __m128d const t {_mm_add_pd(_mm_add_pd(s0, s2), _mm_add_pd(s1, s3))};
+    out[i] = _mm_cvtsd_f64(_mm_add_sd(t, _mm_unpackhi_pd(t, t)));
+    phase += down;
+  }
+}
+
+OB_KERNEL_TARGET("avx2,fma")
+static void sine_avx2(double* out, std::size_t const size, double const c, double const s, double const dc, double const ds) {
+  double lc[4];
+  double ls[4];
+  double wc;
+  double ws;
+  seed(lc, ls, 4, c, s, dc, ds, wc, ws);
+  __m256d vc {_mm256_loadu_pd(lc)};
+  __m256d vs {_mm256_loadu_pd(ls)};
+  __m256d const vwc {_mm256_set1_pd(wc)};
+  __m256d const vws {_mm256_set1_pd(ws)};
+  std::size_t i {0};
+  for (; i + 4 <= size; i += 4) {
+    _mm256_storeu_pd(out + i, vs);
+    __m256d const t {_mm256_fmsub_pd(vc, vwc, _mm256_mul_pd(vs, vws))};
+    vs = _mm256_fmadd_pd(vs, vwc, _mm256_mul_pd(vc, vws));
+    vc = t;
+  }
+  if (i < size) {
+    _mm256_storeu_pd(ls, vs);
+    std::copy(ls, ls + (size - i), out + i);
+  }
+}
+
+OB_KERNEL_TARGET("avx2,fma")
+static void sine_poly_avx2(double* out, std::size_t const size, std::uint64_t const phase, std::uint64_t const step) {
+  std::uint64_t lp[4];
+  for (std::size_t i = 0; i < 4; ++i) {lp[i] = phase + triangle_offset + i * step;}
+  __m256i vp {_mm256_loadu_si256(reinterpret_cast<__m256i const*>(lp))};
+  __m256i const vstep {_mm256_set1_epi64x(static_cast<long long>(4 * step))};
+  __m256i const high {_mm256_setr_epi32(1, 3, 5, 7, 1, 3, 5, 7)};
+  __m256d const one {_mm256_set1_pd(1.0)};
+  __m256d const scale {_mm256_set1_pd(0x1p-30)};
+  __m256d const sign {_mm256_set1_pd(-0.0)};
+  std::size_t i {0};
+  for (; i + 4 <= size; i += 4) {
+    __m256d const v {_mm256_cvtepi32_pd(_mm256_castsi256_si128(_mm256_permutevar8x32_epi32(vp, high)))};
+    __m256d const t {_mm256_fnmadd_pd(_mm256_andnot_pd(sign, v), scale, one)};
+    __m256d const t2 {_mm256_mul_pd(t, t)};
+    __m256d p {_mm256_set1_pd(poly_c9)};
+    p = _mm256_fmadd_pd(p, t2, _mm256_set1_pd(poly_c7));
+    p = _mm256_fmadd_pd(p, t2, _mm256_set1_pd(poly_c5));
+    p = _mm256_fmadd_pd(p, t2, _mm256_set1_pd(poly_c3));
+    p = _mm256_fmadd_pd(p, t2, _mm256_set1_pd(poly_c1));
+    _mm256_storeu_pd(out + i, _mm256_mul_pd(p, t));
+    vp = _mm256_add_epi64(vp, vstep);
+  }
+  _mm256_zeroupper();
+  if (i < size) {
+    sine_poly_scalar(out + i, size - i, phase + i * step, step);
+  }
+}
+
+// the fraction below the index bits is placed in the mantissa of a double
+// in [1, 2), which avoids the missing unsigned 64-bit conversion
+OB_KERNEL_TARGET("avx2,fma")
+static void modulate_avx2(double* out, std::size_t const size, double const* mod, double const depth, std::uint64_t const phase, std::uint64_t const step) {
+  std::uint64_t lp[4];
+  for (std::size_t i = 0; i < 4; ++i) {lp[i] = phase + triangle_offset + i * step;}
+  __m256i vp {_mm256_loadu_si256(reinterpret_cast<__m256i const*>(lp))};
+  __m256i const vstep {_mm256_set1_epi64x(static_cast<long long>(4 * step))};
+  __m256i const high {_mm256_setr_epi32(1, 3, 5, 7, 1, 3, 5, 7)};
+  __m256d const vscale {_mm256_set1_pd(depth * 0x1p32)};
+  __m256d const magic {_mm256_set1_pd(round_magic)};
+  __m256d const one {_mm256_set1_pd(1.0)};
+  __m256d const scale {_mm256_set1_pd(0x1p-30)};
+  __m256d const sign {_mm256_set1_pd(-0.0)};
+  std::size_t i {0};
+  for (; i + 4 <= size; i += 4) {
+    __m256i const shift {_mm256_slli_epi64(_mm256_castpd_si256(_mm256_add_pd(_mm256_mul_pd(_mm256_loadu_pd(mod + i), vscale), magic)), 32)};
+    __m256d const v {_mm256_cvtepi32_pd(_mm256_castsi256_si128(_mm256_permutevar8x32_epi32(_mm256_add_epi64(vp, shift), high)))};
+    __m256d const t {_mm256_fnmadd_pd(_mm256_andnot_pd(sign, v), scale, one)};
+    __m256d const t2 {_mm256_mul_pd(t, t)};
+    __m256d p {_mm256_set1_pd(poly_c9)};
+    p = _mm256_fmadd_pd(p, t2, _mm256_set1_pd(poly_c7));
+    p = _mm256_fmadd_pd(p, t2, _mm256_set1_pd(poly_c5));
+    p = _mm256_fmadd_pd(p, t2, _mm256_set1_pd(poly_c3));
+    p = _mm256_fmadd_pd(p, t2, _mm256_set1_pd(poly_c1));
+    _mm256_storeu_pd(out + i, _mm256_mul_pd(p, t));
+    vp = _mm256_add_epi64(vp, vstep);
+  }
+  _mm256_zeroupper();
+  if (i < size) {
+    modulate_scalar(out + i, size - i, mod + i, depth, phase + i * step, step);
+  }
+}
+
+template<unsigned int Bits>
+OB_KERNEL_TARGET("avx2,fma")
+static void lookup_avx2(double* out, std::size_t const size, double const* table, std::uint64_t const phase, std::uint64_t const step) {
+  std::uint64_t lp[4];
+  for (std::size_t i = 0; i < 4; ++i) {lp[i] = phase + i * step;}
+  __m256i vp {_mm256_loadu_si256(reinterpret_cast<__m256i const*>(lp))};
+  __m256i const vstep {_mm256_set1_epi64x(static_cast<long long>(4 * step))};
+  __m256i const exponent {_mm256_castpd_si256(_mm256_set1_pd(1.0))};
+  __m256d const one {_mm256_set1_pd(1.0)};
+  std::size_t i {0};
+  for (; i + 4 <= size; i += 4) {
+    __m256i const idx {_mm256_srli_epi64(vp, 64 - Bits)};
+    __m256d const frac {_mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(_mm256_slli_epi64(vp, Bits), 12), exponent)), one)};
+    __m256d const a {_mm256_i64gather_pd(table, idx, 8)};
+    __m256d const b {_mm256_i64gather_pd(table + 1, idx, 8)};
+    _mm256_storeu_pd(out + i, _mm256_fmadd_pd(_mm256_sub_pd(b, a), frac, a));
+    vp = _mm256_add_epi64(vp, vstep);
+  }
+  _mm256_zeroupper();
+  if (i < size) {
+    lookup_scalar<Bits>(out + i, size - i, table, phase + i * step, step);
+  }
+}
+
+static void sine_table_avx2(double* out, std::size_t const size, std::uint64_t const phase, std::uint64_t const step) {
+  lookup_avx2<lut_bits>(out, size, lut.data(), phase, step);
+}
+
+OB_KERNEL_TARGET("avx2")
+static void square_avx2(double* out, std::size_t const size, std::uint64_t const phase, std::uint64_t const step) {
+  std::uint64_t lp[4] {phase, phase + step, phase + 2 * step, phase + 3 * step};
+  __m256i vp {_mm256_loadu_si256(reinterpret_cast<__m256i const*>(lp))};
+  __m256i const vstep {_mm256_set1_epi64x(static_cast<long long>(4 * step))};
+  __m256i const sign {_mm256_castpd_si256(_mm256_set1_pd(-0.0))};
+  __m256i const one {_mm256_castpd_si256(_mm256_set1_pd(1.0))};
+  std::size_t i {0};
+  for (; i + 4 <= size; i += 4) {
+    _mm256_storeu_pd(out + i, _mm256_castsi256_pd(_mm256_or_si256(one, _mm256_and_si256(vp, sign))));
+    vp = _mm256_add_epi64(vp, vstep);
+  }
+  _mm256_zeroupper();
+  if (i < size) {
+    square_scalar(out + i, size - i, phase + i * step, step);
+  }
+}
+
+OB_KERNEL_TARGET("avx2")
+static void triangle_avx2(double* out, std::size_t const size, std::uint64_t const phase, std::uint64_t const step) {
+  std::uint64_t lp[4];
+  for (std::size_t i = 0; i < 4; ++i) {lp[i] = phase + triangle_offset + i * step;}
+  __m256i vp {_mm256_loadu_si256(reinterpret_cast<__m256i const*>(lp))};
+  __m256i const vstep {_mm256_set1_epi64x(static_cast<long long>(4 * step))};
+  __m256i const high {_mm256_setr_epi32(1, 3, 5, 7, 1, 3, 5, 7)};
+  __m256d const one {_mm256_set1_pd(1.0)};
+  __m256d const scale {_mm256_set1_pd(0x1p-30)};
+  __m256d const sign {_mm256_set1_pd(-0.0)};
+  std::size_t i {0};
+  for (; i + 4 <= size; i += 4) {
+    __m256d const v {_mm256_cvtepi32_pd(_mm256_castsi256_si128(_mm256_permutevar8x32_epi32(vp, high)))};
+    _mm256_storeu_pd(out + i, _mm256_sub_pd(one, _mm256_mul_pd(_mm256_andnot_pd(sign, v), scale)));
+    vp = _mm256_add_epi64(vp, vstep);
+  }
+  _mm256_zeroupper();
+  if (i < size) {
+    triangle_scalar(out + i, size - i, phase + i * step, step);
+  }
+}
+
+OB_KERNEL_TARGET("avx2")
+static void saw_avx2(double* out, std::size_t const size, std::uint64_t const phase, std::uint64_t const step) {
+  std::uint64_t lp[4];
+  for (std::size_t i = 0; i < 4; ++i) {lp[i] = phase + i * step;}
+  __m256i vp {_mm256_loadu_si256(reinterpret_cast<__m256i const*>(lp))};
+  __m256i const vstep {_mm256_set1_epi64x(static_cast<long long>(4 * step))};
+  __m256i const high {_mm256_setr_epi32(1, 3, 5, 7, 1, 3, 5, 7)};
+  __m256d const scale {_mm256_set1_pd(0x1p-31)};
+  std::size_t i {0};
+  for (; i + 4 <= size; i += 4) {
+    __m256d const v {_mm256_cvtepi32_pd(_mm256_castsi256_si128(_mm256_permutevar8x32_epi32(vp, high)))};
+    _mm256_storeu_pd(out + i, _mm256_mul_pd(v, scale));
+    vp = _mm256_add_epi64(vp, vstep);
+  }
+  _mm256_zeroupper();
+  if (i < size) {
+    saw_scalar(out + i, size - i, phase + i * step, step);
+  }
+}
+
+OB_KERNEL_TARGET("avx2")
+static void quantize_avx2(short* out, double const* in, std::size_t const size, double const gain) {
+  __m256d const vgain {_mm256_set1_pd(gain)};
+  __m256d const lo {_mm256_set1_pd(-32768.0)};
+  __m256d const hi {_mm256_set1_pd(32767.0)};
+  std::size_t i {0};
+  for (; i + 8 <= size; i += 8) {
+    __m128i const a {_mm256_cvttpd_epi32(_mm256_min_pd(_mm256_max_pd(_mm256_mul_pd(_mm256_loadu_pd(in + i), vgain), lo), hi))};
+    __m128i const b {_mm256_cvttpd_epi32(_mm256_min_pd(_mm256_max_pd(_mm256_mul_pd(_mm256_loadu_pd(in + i + 4), vgain), lo), hi))};
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(a, b));
+  }
+  // gcc omits vzeroupper before the tail call, leaving the scalar code
+  // paying the avx to sse transition penalty
+  _mm256_zeroupper();
+  quantize_scalar(out + i, in + i, size - i, gain);
+}
+
+OB_KERNEL_TARGET("avx2")
+static void spread_avx2(short* out, short const* in, std::size_t const size, std::uint16_t const left, std::uint16_t const right) {
+  __m256i const mask {_mm256_set1_epi32(static_cast<int>(left | (static_cast<std::uint32_t>(right) << 16)))};
+  std::size_t i {0};
+  for (; i + 8 <= size; i += 8) {
+    __m256i const v {_mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(in + i)))};
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 2 * i), _mm256_and_si256(_mm256_or_si256(v, _mm256_slli_epi32(v, 16)), mask));
+  }
+  _mm256_zeroupper();
+  spread_scalar(out + 2 * i, in + i, size - i, left, right);
+}
+
+OB_KERNEL_TARGET("avx2")
+static void round32_avx2(std::int32_t* out, double const* in, std::size_t const size, double const gain) {
+  __m256d const vgain {_mm256_set1_pd(gain)};
+  __m256d const lo {_mm256_set1_pd(-2147483648.0)};
+  __m256d const hi {_mm256_set1_pd(2147483647.0)};
+  std::size_t i {0};
+  for (; i + 8 <= size; i += 8) {
+    __m128i const a {_mm256_cvtpd_epi32(_mm256_min_pd(_mm256_max_pd(_mm256_mul_pd(_mm256_loadu_pd(in + i), vgain), lo), hi))};
+    __m128i const b {_mm256_cvtpd_epi32(_mm256_min_pd(_mm256_max_pd(_mm256_mul_pd(_mm256_loadu_pd(in + i + 4), vgain), lo), hi))};
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_inserti128_si256(_mm256_castsi128_si256(a), b, 1));
+  }
+  _mm256_zeroupper();
+  round32_scalar(out + i, in + i, size - i, gain);
+}
+
+OB_KERNEL_TARGET("avx2")
+static void narrow_avx2(float* out, double const* in, std::size_t const size, double const gain) {
+  __m256d const vgain {_mm256_set1_pd(gain)};
+  std::size_t i {0};
+  for (; i + 8 <= size; i += 8) {
+    __m128 const a {_mm256_cvtpd_ps(_mm256_mul_pd(_mm256_loadu_pd(in + i), vgain))};
+    __m128 const b {_mm256_cvtpd_ps(_mm256_mul_pd(_mm256_loadu_pd(in + i + 4), vgain))};
+    _mm256_storeu_ps(out + i, _mm256_insertf128_ps(_mm256_castps128_ps256(a), b, 1));
+  }
+  _mm256_zeroupper();
+  narrow_scalar(out + i, in + i, size - i, gain);
+}
+
+OB_KERNEL_TARGET("avx2")
+static void spread32_avx2(std::uint32_t* out, std::uint32_t const* in, std::size_t const size, std::uint32_t const left, std::uint32_t const right) {
+  __m256i const mask {_mm256_set1_epi64x(static_cast<long long>(left | (static_cast<std::uint64_t>(right) << 32)))};
+  std::size_t i {0};
+  for (; i + 4 <= size; i += 4) {
+    __m256i const v {_mm256_cvtepu32_epi64(_mm_loadu_si128(reinterpret_cast<__m128i const*>(in + i)))};
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 2 * i), _mm256_and_si256(_mm256_or_si256(v, _mm256_slli_epi64(v, 32)), mask));
+  }
+  _mm256_zeroupper();
+  spread32_scalar(out + 2 * i, in + i, size - i, left, right);
+}
+
+// each lane drops the top byte of its four samples, then the two 12 byte runs
+// are joined, the 8 bytes stored past them are overwritten by the next pass
+OB_KERNEL_TARGET("avx2")
+static void pack24_avx2(std::uint8_t* out, std::int32_t const* in, std::size_t const size) {
+  __m256i const bytes {_mm256_setr_epi8(
+    0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+    0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1)};
+  __m256i const words {_mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7)};
+  std::size_t i {0};
+  // the store runs 8 bytes past the packed samples, which must stay in bounds
+  for (; i + 11 <= size; i += 8) {
+    __m256i const v {_mm256_loadu_si256(reinterpret_cast<__m256i const*>(in + i))};
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 3 * i), _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(v, bytes), words));
+  }
+  _mm256_zeroupper();
+  pack24_scalar(out + 3 * i, in + i, size - i);
+}
+
+// unpacking works within 128-bit lanes, so the lane halves are swapped back
+// into order before the store
+OB_KERNEL_TARGET("avx2")
+static void interleave16_avx2(std::uint16_t* out, std::uint16_t const* left, std::uint16_t const* right, std::size_t const size) {
+  std::size_t i {0};
+  for (; i + 16 <= size; i += 16) {
+    __m256i const l {_mm256_loadu_si256(reinterpret_cast<__m256i const*>(left + i))};
+    __m256i const r {_mm256_loadu_si256(reinterpret_cast<__m256i const*>(right + i))};
+    __m256i const lo {_mm256_unpacklo_epi16(l, r)};
+    __m256i const hi {_mm256_unpackhi_epi16(l, r)};
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 2 * i), _mm256_permute2x128_si256(lo, hi, 0x20));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 2 * i + 16), _mm256_permute2x128_si256(lo, hi, 0x31));
+  }
+  _mm256_zeroupper();
+  interleave_scalar(out + 2 * i, left + i, right + i, size - i);
+}
+
+OB_KERNEL_TARGET("avx2")
+static void interleave32_avx2(std::uint32_t* out, std::uint32_t const* left, std::uint32_t const* right, std::size_t const size) {
+  std::size_t i {0};
+  for (; i + 8 <= size; i += 8) {
+    __m256i const l {_mm256_loadu_si256(reinterpret_cast<__m256i const*>(left + i))};
+    __m256i const r {_mm256_loadu_si256(reinterpret_cast<__m256i const*>(right + i))};
+    __m256i const lo {_mm256_unpacklo_epi32(l, r)};
+    __m256i const hi {_mm256_unpackhi_epi32(l, r)};
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 2 * i), _mm256_permute2x128_si256(lo, hi, 0x20));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 2 * i + 8), _mm256_permute2x128_si256(lo, hi, 0x31));
+  }
+  _mm256_zeroupper();
+  interleave_scalar(out + 2 * i, left + i, right + i, size - i);
+}
+
+OB_KERNEL_TARGET("avx2")
+static void interleave64_avx2(std::uint64_t* out, std::uint64_t const* left, std::uint64_t const* right, std::size_t const size) {
+  std::size_t i {0};
+  for (; i + 4 <= size; i += 4) {
+    __m256i const l {_mm256_loadu_si256(reinterpret_cast<__m256i const*>(left + i))};
+    __m256i const r {_mm256_loadu_si256(reinterpret_cast<__m256i const*>(right + i))};
+    __m256i const lo {_mm256_unpacklo_epi64(l, r)};
+    __m256i const hi {_mm256_unpackhi_epi64(l, r)};
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 2 * i), _mm256_permute2x128_si256(lo, hi, 0x20));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 2 * i + 4), _mm256_permute2x128_si256(lo, hi, 0x31));
+  }
+  _mm256_zeroupper();
+  interleave_scalar(out + 2 * i, left + i, right + i, size - i);
+}
+
+// each vector is gathered into a left half and right half per lane, then
+// into a left and right lane, and the lanes of two vectors are joined
+OB_KERNEL_TARGET("avx2")
+static void deinterleave16_avx2(std::uint16_t* left, std::uint16_t* right, std::uint16_t const* in, std::size_t const size) {
+  __m256i const bytes {_mm256_setr_epi8(
+    0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15,
+    0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15)};
+  std::size_t i {0};
+  for (; i + 16 <= size; i += 16) {
+    __m256i const a {_mm256_permute4x64_epi64(_mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(in + 2 * i)), bytes), 0xd8)};
+    __m256i const b {_mm256_permute4x64_epi64(_mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(in + 2 * i + 16)), bytes), 0xd8)};
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(left + i), _mm256_permute2x128_si256(a, b, 0x20));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(right + i), _mm256_permute2x128_si256(a, b, 0x31));
+  }
+  _mm256_zeroupper();
+  deinterleave_scalar(left + i, right + i, in + 2 * i, size - i);
+}
+
+OB_KERNEL_TARGET("avx2")
+static void deinterleave32_avx2(std::uint32_t* left, std::uint32_t* right, std::uint32_t const* in, std::size_t const size) {
+  std::size_t i {0};
+  for (; i + 8 <= size; i += 8) {
+    __m256i const a {_mm256_permute4x64_epi64(_mm256_shuffle_epi32(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(in + 2 * i)), 0xd8), 0xd8)};
+    __m256i const b {_mm256_permute4x64_epi64(_mm256_shuffle_epi32(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(in + 2 * i + 8)), 0xd8), 0xd8)};
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(left + i), _mm256_permute2x128_si256(a, b, 0x20));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(right + i), _mm256_permute2x128_si256(a, b, 0x31));
+  }
+  _mm256_zeroupper();
+  deinterleave_scalar(left + i, right + i, in + 2 * i, size - i);
+}
+
+OB_KERNEL_TARGET("avx2")
+static void deinterleave64_avx2(std::uint64_t* left, std::uint64_t* right, std::uint64_t const* in, std::size_t const size) {
+  std::size_t i {0};
+  for (; i + 4 <= size; i += 4) {
+    __m256i const a {_mm256_loadu_si256(reinterpret_cast<__m256i const*>(in + 2 * i))};
+    __m256i const b {_mm256_loadu_si256(reinterpret_cast<__m256i const*>(in + 2 * i + 4))};
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(left + i), _mm256_permute4x64_epi64(_mm256_unpacklo_epi64(a, b), 0xd8));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(right + i), _mm256_permute4x64_epi64(_mm256_unpackhi_epi64(a, b), 0xd8));
+  }
+  _mm256_zeroupper();
+  deinterleave_scalar(left + i, right + i, in + 2 * i, size - i);
+}
+
+OB_KERNEL_TARGET("avx2")
+static void tpdf_avx2(double* out, std::size_t const size, std::uint32_t const key, std::uint32_t const counter) {
+  __m256i const step {_mm256_set1_epi32(8)};
+  __m256i const m1 {_mm256_set1_epi32(0x7feb352d)};
+  __m256i const m2 {_mm256_set1_epi32(static_cast<int>(0x846ca68bu))};
+  __m256i const low {_mm256_set1_epi32(0xffff)};
+  __m256i const bias {_mm256_set1_epi32(65535)};
+  __m256d const scale {_mm256_set1_pd(tpdf_scale)};
+  __m256i x {_mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(counter + key)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7))};
+  std::size_t i {0};
+  for (; i + 8 <= size; i += 8) {
+    __m256i h {_mm256_xor_si256(x, _mm256_srli_epi32(x, 16))};
+    h = _mm256_mullo_epi32(h, m1);
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 15));
+    h = _mm256_mullo_epi32(h, m2);
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+    __m256i const s {_mm256_sub_epi32(_mm256_add_epi32(_mm256_and_si256(h, low), _mm256_srli_epi32(h, 16)), bias)};
+    _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(s)), scale));
+    _mm256_storeu_pd(out + i + 4, _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(s, 1)), scale));
+    x = _mm256_add_epi32(x, step);
+  }
+  _mm256_zeroupper();
+  tpdf_scalar(out + i, size - i, key, static_cast<std::uint32_t>(counter + i));
+}
+
+OB_KERNEL_TARGET("avx2")
+static __m256i hash32_avx2(__m256i x) {
+  x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+  x = _mm256_mullo_epi32(x, _mm256_set1_epi32(0x7feb352d));
+  x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 15));
+  x = _mm256_mullo_epi32(x, _mm256_set1_epi32(static_cast<int>(0x846ca68bu)));
+  return _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+}
+
+OB_KERNEL_TARGET("avx2")
+static void noise_avx2(double* out, std::size_t const size, std::uint32_t const* keys, double const* weights, std::size_t const rows, std::uint32_t const counter, bool const ramp) {
+  __m256i const one {_mm256_set1_epi32(1)};
+  __m256d const scale {_mm256_set1_pd(0x1p-31)};
+  __m256i frame {_mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(counter)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7))};
+  std::size_t i {0};
+  for (; i + 8 <= size; i += 8) {
+    __m256d lo {_mm256_setzero_pd()};
+    __m256d hi {_mm256_setzero_pd()};
+    for (std::size_t k = 0; k < rows; ++k) {
+      __m256i const idx {_mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(keys[k])), _mm256_srl_epi32(frame, _mm_cvtsi32_si128(static_cast<int>(k))))};
+      __m256i const h {hash32_avx2(idx)};
+      __m256d vlo {_mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(h)), scale)};
+      __m256d vhi {_mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(h, 1)), scale)};
+      if (ramp && k) {
+        __m256i const next {hash32_avx2(_mm256_add_epi32(idx, one))};
+        __m256i const part {_mm256_and_si256(frame, _mm256_set1_epi32(static_cast<int>((std::uint32_t {1} << k) - 1)))};
+        __m256d const step {_mm256_set1_pd(std::ldexp(1.0, -static_cast<int>(k)))};
+        vlo = _mm256_add_pd(vlo, _mm256_mul_pd(_mm256_sub_pd(_mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(next)), scale), vlo), _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(part)), step)));
+        vhi = _mm256_add_pd(vhi, _mm256_mul_pd(_mm256_sub_pd(_mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(next, 1)), scale), vhi), _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(part, 1)), step)));
+      }
+      __m256d const weight {_mm256_set1_pd(weights[k])};
+      lo = _mm256_add_pd(lo, _mm256_mul_pd(weight, vlo));
+      hi = _mm256_add_pd(hi, _mm256_mul_pd(weight, vhi));
+    }
+    _mm256_storeu_pd(out + i, lo);
+    _mm256_storeu_pd(out + i + 4, hi);
+    frame = _mm256_add_epi32(frame, _mm256_set1_epi32(8));
+  }
+  _mm256_zeroupper();
+  noise_scalar(out + i, size - i, keys, weights, rows, static_cast<std::uint32_t>(counter + i), ramp);
+}
+
+OB_KERNEL_TARGET("avx2")
+static void expand_avx2(double* out, std::size_t const size, double const* coarse, std::size_t const offset, bool const ramp) {
+  std::size_t i {std::min(size, (4 - (offset & 3)) & 3)};
+  expand_scalar(out, i, coarse, offset, ramp);
+  __m256d const frac {_mm256_setr_pd(0.0, 0.25, 0.5, 0.75)};
+  for (std::size_t j = (offset + i) >> 2; i + 4 <= size; i += 4, ++j) {
+    __m256d val {_mm256_broadcast_sd(coarse + j)};
+    if (ramp) {
+      val = _mm256_add_pd(val, _mm256_mul_pd(_mm256_sub_pd(_mm256_broadcast_sd(coarse + j + 1), val), frac));
+    }
+    _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_loadu_pd(out + i), val));
+  }
+  _mm256_zeroupper();
+  expand_scalar(out + i, size - i, coarse + ((offset + i) >> 2), 0, ramp);
+}
+
+OB_KERNEL_TARGET("avx2")
+static void requantize_avx2(double* out, double const* in, double const* noise, std::size_t const size, double const gain, double const lo, double const hi) {
+  __m256d const vgain {_mm256_set1_pd(gain)};
+  __m256d const vlo {_mm256_set1_pd(lo)};
+  __m256d const vhi {_mm256_set1_pd(hi)};
+  __m256d const magic {_mm256_set1_pd(round_magic)};
+  std::size_t i {0};
+  for (; i + 4 <= size; i += 4) {
+    __m256d const v {_mm256_min_pd(_mm256_max_pd(_mm256_add_pd(_mm256_mul_pd(_mm256_loadu_pd(in + i), vgain), _mm256_loadu_pd(noise + i)), vlo), vhi)};
+    _mm256_storeu_pd(out + i, _mm256_sub_pd(_mm256_add_pd(v, magic), magic));
+  }
+  _mm256_zeroupper();
+  requantize_scalar(out + i, in + i, noise + i, size - i, gain, lo, hi);
+}
+
+// all four runs share one register, avx512 has no more runs to fill its own
+OB_KERNEL_TARGET("avx2")
+static void shape_avx2(double* out, double const* in, double const* noise, std::size_t const size, std::size_t const stride, std::size_t const lead, double const* coefs, double const gain, double const lo, double const hi, double const limit) {
+  __m256d const c0 {_mm256_set1_pd(coefs[0])};
+  __m256d const c1 {_mm256_set1_pd(coefs[1])};
+  __m256d const c2 {_mm256_set1_pd(coefs[2])};
+  __m256d const c3 {_mm256_set1_pd(coefs[3])};
+  __m256d const c4 {_mm256_set1_pd(coefs[4])};
+  __m256d const vgain {_mm256_set1_pd(gain)};
+  __m256d const vlo {_mm256_set1_pd(lo)};
+  __m256d const vhi {_mm256_set1_pd(hi)};
+  __m256d const vmax {_mm256_set1_pd(limit)};
+  __m256d const vmin {_mm256_set1_pd(-limit)};
+  __m256d const magic {_mm256_set1_pd(round_magic)};
+  __m256d e0 {_mm256_setzero_pd()};
+  __m256d e1 {e0};
+  __m256d e2 {e0};
+  __m256d e3 {e0};
+  __m256d e4 {e0};
+  for (std::size_t i = 0; i < size; ++i) {
+    __m256d const x {_mm256_set_pd(in[i + 3 * stride], in[i + 2 * stride], in[i + stride], in[i])};
+    __m256d const n {_mm256_set_pd(noise[i + 3 * stride], noise[i + 2 * stride], noise[i + stride], noise[i])};
+    __m256d const rest {_mm256_add_pd(_mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(c4, e4), _mm256_mul_pd(c3, e3)), _mm256_mul_pd(c2, e2)), _mm256_mul_pd(c1, e1))};
+    __m256d const val {_mm256_sub_pd(_mm256_sub_pd(_mm256_mul_pd(x, vgain), rest), _mm256_mul_pd(c0, e0))};
+    __m256d const step {_mm256_sub_pd(_mm256_add_pd(_mm256_min_pd(_mm256_max_pd(_mm256_add_pd(val, n), vlo), vhi), magic), magic)};
+    e4 = e3;
+    e3 = e2;
+    e2 = e1;
+    e1 = e0;
+    e0 = _mm256_min_pd(_mm256_max_pd(_mm256_sub_pd(step, val), vmin), vmax);
+    if (i >= lead) {
+      __m128d const low {_mm256_castpd256_pd128(step)};
+      __m128d const high {_mm256_extractf128_pd(step, 1)};
+      _mm_storel_pd(out + i, low);
+      _mm_storeh_pd(out + i + stride, low);
+      _mm_storel_pd(out + i + 2 * stride, high);
+      _mm_storeh_pd(out + i + 3 * stride, high);
+    }
+  }
+  _mm256_zeroupper();
+}
+
+OB_KERNEL_TARGET("avx2")
+static void partials_avx2(double* out, std::size_t const size, double const* sine, double const* cosine, double const* amps, std::size_t const count) {
+  std::size_t i {0};
+  // four independent recurrences hide the latency of each step
+  for (; i + 16 <= size; i += 16) {
+    __m256d const c0 {_mm256_loadu_pd(cosine + i)};
+    __m256d const c1 {_mm256_loadu_pd(cosine + i + 4)};
+    __m256d const c2 {_mm256_loadu_pd(cosine + i + 8)};
+    __m256d const c3 {_mm256_loadu_pd(cosine + i + 12)};
+    __m256d const twice0 {_mm256_add_pd(c0, c0)};
+    __m256d const twice1 {_mm256_add_pd(c1, c1)};
+    __m256d const twice2 {_mm256_add_pd(c2, c2)};
+    __m256d const twice3 {_mm256_add_pd(c3, c3)};
+    __m256d prev0 {_mm256_setzero_pd()};
+    __m256d prev1 {_mm256_setzero_pd()};
+    __m256d prev2 {_mm256_setzero_pd()};
+    __m256d prev3 {_mm256_setzero_pd()};
+    __m256d cur0 {_mm256_loadu_pd(sine + i)};
+    __m256d cur1 {_mm256_loadu_pd(sine + i + 4)};
+    __m256d cur2 {_mm256_loadu_pd(sine + i + 8)};
+    __m256d cur3 {_mm256_loadu_pd(sine + i + 12)};
+    __m256d const amp {_mm256_set1_pd(amps[0])};
+    __m256d acc0 {_mm256_mul_pd(amp, cur0)};
+    __m256d acc1 {_mm256_mul_pd(amp, cur1)};
+    __m256d acc2 {_mm256_mul_pd(amp, cur2)};
+    __m256d acc3 {_mm256_mul_pd(amp, cur3)};
+    for (std::size_t k = 1; k < count; ++k) {
+      __m256d const gain {_mm256_set1_pd(amps[k])};
+      __m256d const next0 {_mm256_sub_pd(_mm256_mul_pd(twice0, cur0), prev0)};
+      __m256d const next1 {_mm256_sub_pd(_mm256_mul_pd(twice1, cur1), prev1)};
+      __m256d const next2 {_mm256_sub_pd(_mm256_mul_pd(twice2, cur2), prev2)};
+      __m256d const next3 {_mm256_sub_pd(_mm256_mul_pd(twice3, cur3), prev3)};
+      prev0 = cur0;
+      prev1 = cur1;
+      prev2 = cur2;
+      prev3 = cur3;
+      cur0 = next0;
+      cur1 = next1;
+      cur2 = next2;
+      cur3 = next3;
+      acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(gain, cur0));
+      acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(gain, cur1));
+      acc2 = _mm256_add_pd(acc2, _mm256_mul_pd(gain, cur2));
+      acc3 = _mm256_add_pd(acc3, _mm256_mul_pd(gain, cur3));
+    }
+    _mm256_storeu_pd(out + i, acc0);
+    _mm256_storeu_pd(out + i + 4, acc1);
+    _mm256_storeu_pd(out + i + 8, acc2);
+    _mm256_storeu_pd(out + i + 12, acc3);
+  }
+  _mm256_zeroupper();
+  partials_scalar(out + i, size - i, sine + i, cosine + i, amps, count);
+}
+
+OB_KERNEL_TARGET("avx2")
+static void halfband_avx2(double* out, double const* even, double const* odd, std::size_t const size, double const* taps, std::size_t const count) {
+  __m256d const half {_mm256_set1_pd(0.5)};
+  std::size_t i {0};
+  // four independent sums hide the latency of the adds
+  for (; i + 16 <= size; i += 16) {
+    double const* lo {even + i + count - 1};
+    double const* hi {even + i + count};
+    __m256d acc0 {_mm256_setzero_pd()};
+    __m256d acc1 {_mm256_setzero_pd()};
+    __m256d acc2 {_mm256_setzero_pd()};
+    __m256d acc3 {_mm256_setzero_pd()};
+    for (std::size_t j = count; j-- > 0;) {
+      __m256d const tap {_mm256_set1_pd(taps[j])};
+      acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(tap, _mm256_add_pd(_mm256_loadu_pd(lo - j), _mm256_loadu_pd(hi + j))));
+      acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(tap, _mm256_add_pd(_mm256_loadu_pd(lo - j + 4), _mm256_loadu_pd(hi + j + 4))));
+      acc2 = _mm256_add_pd(acc2, _mm256_mul_pd(tap, _mm256_add_pd(_mm256_loadu_pd(lo - j + 8), _mm256_loadu_pd(hi + j + 8))));
+      acc3 = _mm256_add_pd(acc3, _mm256_mul_pd(tap, _mm256_add_pd(_mm256_loadu_pd(lo - j + 12), _mm256_loadu_pd(hi + j + 12))));
+    }
+    double const* mid {odd + i + count - 1};
+    _mm256_storeu_pd(out + i, _mm256_add_pd(acc0, _mm256_mul_pd(half, _mm256_loadu_pd(mid))));
+    _mm256_storeu_pd(out + i + 4, _mm256_add_pd(acc1, _mm256_mul_pd(half, _mm256_loadu_pd(mid + 4))));
+    _mm256_storeu_pd(out + i + 8, _mm256_add_pd(acc2, _mm256_mul_pd(half, _mm256_loadu_pd(mid + 8))));
+    _mm256_storeu_pd(out + i + 12, _mm256_add_pd(acc3, _mm256_mul_pd(half, _mm256_loadu_pd(mid + 12))));
+  }
+  _mm256_zeroupper();
+  halfband_scalar(out + i, even + i, odd + i, size - i, taps, count);
+}
+
+OB_KERNEL_TARGET("avx2")
+static void polyphase_avx2(double* out, std::size_t const size, double const* in, double const* bank, std::size_t const taps, std::size_t const up, std::size_t const down, std::size_t phase) {
+  for (std::size_t i = 0; i < size; ++i) {
+    double const* x {in + phase / up};
+    double const* h {bank + (phase % up) * taps};
+    __m256d lo {_mm256_setzero_pd()};
+    __m256d hi {_mm256_setzero_pd()};
+    for (std::size_t k = 0; k < taps; k += 8) {
+      lo = _mm256_add_pd(lo, _mm256_mul_pd(_mm256_loadu_pd(h + k), _mm256_loadu_pd(x + k)));
+      hi = _mm256_add_pd(hi, _mm256_mul_pd(_mm256_loadu_pd(h + k + 4), _mm256_loadu_pd(x + k + 4)));
+    }
+    __m256d const t {_mm256_add_pd(lo, hi)};
+    __m128d const u {_mm_add_pd(_mm256_castpd256_pd128(t), _mm256_extractf128_pd(t, 1))};
+    out[i] = _mm_cvtsd_f64(_mm_add_sd(u, _mm_unpackhi_pd(u, u)));
+    phase += down;
+  }
+  _mm256_zeroupper();
+}
+
+OB_KERNEL_TARGET("avx512f")
+static void sine_avx512(double* out, std::size_t const size, double const c, double const s, double const dc, double const ds) {
+  double lc[8];
+  double ls[8];
+  double wc;
+  double ws;
+  seed(lc, ls, 8, c, s, dc, ds, wc, ws);
+  __m512d vc {_mm512_loadu_pd(lc)};
+  __m512d vs {_mm512_loadu_pd(ls)};
+  __m512d const vwc {_mm512_set1_pd(wc)};
+  __m512d const vws {_mm512_set1_pd(ws)};
+  std::size_t i {0};
+  for (; i + 8 <= size; i += 8) {
+    _mm512_storeu_pd(out + i, vs);
+    __m512d const t {_mm512_fmsub_pd(vc, vwc, _mm512_mul_pd(vs, vws))};
+    vs = _mm512_fmadd_pd(vs, vwc, _mm512_mul_pd(vc, vws));
+    vc = t;
+  }
+  if (i < size) {
+    _mm512_mask_storeu_pd(out + i, static_cast<__mmask8>((1u << (size - i)) - 1), vs);
+  }
+}
+
+OB_KERNEL_TARGET("avx512f")
+static void sine_poly_avx512(double* out, std::size_t const size, std::uint64_t const phase, std::uint64_t const step) {
+  std::uint64_t lp[8];
+  for (std::size_t i = 0; i < 8; ++i) {lp[i] = phase + triangle_offset + i * step;}
+  __m512i vp {_mm512_loadu_si512(lp)};
+  __m512i const vstep {_mm512_set1_epi64(static_cast<long long>(8 * step))};
+  __m512d const one {_mm512_set1_pd(1.0)};
+  __m512d const scale {_mm512_set1_pd(0x1p-30)};
+  std::size_t i {0};
+  for (; i + 8 <= size; i += 8) {
+    __m512d const v {_mm512_cvtepi32_pd(_mm512_cvtepi64_epi32(_mm512_srli_epi64(vp, 32)))};
+    __m512d const t {_mm512_fnmadd_pd(_mm512_abs_pd(v), scale, one)};
+    __m512d const t2 {_mm512_mul_pd(t, t)};
+    __m512d p {_mm512_set1_pd(poly_c9)};
+    p = _mm512_fmadd_pd(p, t2, _mm512_set1_pd(poly_c7));
+    p = _mm512_fmadd_pd(p, t2, _mm512_set1_pd(poly_c5));
+    p = _mm512_fmadd_pd(p, t2, _mm512_set1_pd(poly_c3));
+    p = _mm512_fmadd_pd(p, t2, _mm512_set1_pd(poly_c1));
+    _mm512_storeu_pd(out + i, _mm512_mul_pd(p, t));
+    vp = _mm512_add_epi64(vp, vstep);
+  }
+  _mm256_zeroupper();
+  if (i < size) {
+    sine_poly_scalar(out + i, size - i, phase + i * step, step);
+  }
+}
+
+OB_KERNEL_TARGET("avx512f")
+static void modulate_avx512(double* out, std::size_t const size, double const* mod, double const depth, std::uint64_t const phase, std::uint64_t const step) {
+  std::uint64_t lp[8];
+  for (std::size_t i = 0; i < 8; ++i) {lp[i] = phase + triangle_offset + i * step;}
+  __m512i vp {_mm512_loadu_si512(lp)};
+  __m512i const vstep {_mm512_set1_epi64(static_cast<long long>(8 * step))};
+  __m512d const vscale {_mm512_set1_pd(depth * 0x1p32)};
+  __m512d const magic {_mm512_set1_pd(round_magic)};
+  __m512d const one {_mm512_set1_pd(1.0)};
+  __m512d const scale {_mm512_set1_pd(0x1p-30)};
+  std::size_t i {0};
+  for (; i + 8 <= size; i += 8) {
+    __m512i const shift {_mm512_slli_epi64(_mm512_castpd_si512(_mm512_add_pd(_mm512_mul_pd(_mm512_loadu_pd(mod + i), vscale), magic)), 32)};
+    __m512d const v {_mm512_cvtepi32_pd(_mm512_cvtepi64_epi32(_mm512_srli_epi64(_mm512_add_epi64(vp, shift), 32)))};
+    __m512d const t {_mm512_fnmadd_pd(_mm512_abs_pd(v), scale, one)};
+    __m512d const t2 {_mm512_mul_pd(t, t)};
+    __m512d p {_mm512_set1_pd(poly_c9)};
+    p = _mm512_fmadd_pd(p, t2, _mm512_set1_pd(poly_c7));
+    p = _mm512_fmadd_pd(p, t2, _mm512_set1_pd(poly_c5));
+    p = _mm512_fmadd_pd(p, t2, _mm512_set1_pd(poly_c3));
+    p = _mm512_fmadd_pd(p, t2, _mm512_set1_pd(poly_c1));
+    _mm512_storeu_pd(out + i, _mm512_mul_pd(p, t));
+    vp = _mm512_add_epi64(vp, vstep);
+  }
+  _mm256_zeroupper();
+  if (i < size) {
+    modulate_scalar(out + i, size - i, mod + i, depth, phase + i * step, step);
+  }
+}
+
+template<unsigned int Bits>
+OB_KERNEL_TARGET("avx512f")
+static void lookup_avx512(double* out, std::size_t const size, double const* table, std::uint64_t const phase, std::uint64_t const step) {
+  std::uint64_t lp[8];
+  for (std::size_t i = 0; i < 8; ++i) {lp[i] = phase + i * step;}
+  __m512i vp {_mm512_loadu_si512(lp)};
+  __m512i const vstep {_mm512_set1_epi64(static_cast<long long>(8 * step))};
+  __m512i const exponent {_mm512_castpd_si512(_mm512_set1_pd(1.0))};
+  __m512d const one {_mm512_set1_pd(1.0)};
+  std::size_t i {0};
+  for (; i + 8 <= size; i += 8) {
+    __m512i const idx {_mm512_srli_epi64(vp, 64 - Bits)};
+    __m512d const frac {_mm512_sub_pd(_mm512_castsi512_pd(_mm512_or_si512(_mm512_srli_epi64(_mm512_slli_epi64(vp, Bits), 12), exponent)), one)};
+    __m512d const a {_mm512_i64gather_pd(idx, table, 8)};
+    __m512d const b {_mm512_i64gather_pd(idx, table + 1, 8)};
+    _mm512_storeu_pd(out + i, _mm512_fmadd_pd(_mm512_sub_pd(b, a), frac, a));
+    vp = _mm512_add_epi64(vp, vstep);
+  }
+  _mm256_zeroupper();
+  if (i < size) {
+    lookup_scalar<Bits>(out + i, size - i, table, phase + i * step, step);
+  }
+}
+
+static void sine_table_avx512(double* out, std::size_t const size, std::uint64_t const phase, std::uint64_t const step) {
+  lookup_avx512<lut_bits>(out, size, lut.data(), phase, step);
+}
+
+OB_KERNEL_TARGET("avx512f")
+static void square_avx512(double* out, std::size_t const size, std::uint64_t const phase, std::uint64_t const step) {
+  std::uint64_t lp[8];
+  for (std::size_t i = 0; i < 8; ++i) {lp[i] = phase + i * step;}
+  __m512i vp {_mm512_loadu_si512(lp)};
+  __m512i const vstep {_mm512_set1_epi64(static_cast<long long>(8 * step))};
+  __m512i const sign {_mm512_set1_epi64(static_cast<long long>(0x8000000000000000ull))};
+  __m512i const one {_mm512_castpd_si512(_mm512_set1_pd(1.0))};
+  std::size_t i {0};
+  for (; i + 8 <= size; i += 8) {
+    _mm512_storeu_pd(out + i, _mm512_castsi512_pd(_mm512_or_si512(one, _mm512_and_si512(vp, sign))));
+    vp = _mm512_add_epi64(vp, vstep);
+  }
+  _mm256_zeroupper();
+  if (i < size) {
+    square_scalar(out + i, size - i, phase + i * step, step);
+  }
+}
+
+OB_KERNEL_TARGET("avx512f")
+static void triangle_avx512(double* out, std::size_t const size, std::uint64_t const phase, std::uint64_t const step) {
+  std::uint64_t lp[8];
+  for (std::size_t i = 0; i < 8; ++i) {lp[i] = phase + triangle_offset + i * step;}
+  __m512i vp {_mm512_loadu_si512(lp)};
+  __m512i const vstep {_mm512_set1_epi64(static_cast<long long>(8 * step))};
+  __m512d const one {_mm512_set1_pd(1.0)};
+  __m512d const scale {_mm512_set1_pd(0x1p-30)};
+  std::size_t i {0};
+  for (; i + 8 <= size; i += 8) {
+    __m512d const v {_mm512_cvtepi32_pd(_mm512_cvtepi64_epi32(_mm512_srli_epi64(vp, 32)))};
+    _mm512_storeu_pd(out + i, _mm512_fnmadd_pd(_mm512_abs_pd(v), scale, one));
+    vp = _mm512_add_epi64(vp, vstep);
+  }
+  _mm256_zeroupper();
+  if (i < size) {
+    triangle_scalar(out + i, size - i, phase + i * step, step);
+  }
+}
+
+OB_KERNEL_TARGET("avx512f")
+static void saw_avx512(double* out, std::size_t const size, std::uint64_t const phase, std::uint64_t const step) {
+  std::uint64_t lp[8];
+  for (std::size_t i = 0; i < 8; ++i) {lp[i] = phase + i * step;}
+  __m512i vp {_mm512_loadu_si512(lp)};
+  __m512i const vstep {_mm512_set1_epi64(static_cast<long long>(8 * step))};
+  __m512d const scale {_mm512_set1_pd(0x1p-31)};
+  std::size_t i {0};
+  for (; i + 8 <= size; i += 8) {
+    __m512d const v {_mm512_cvtepi32_pd(_mm512_cvtepi64_epi32(_mm512_srli_epi64(vp, 32)))};
+    _mm512_storeu_pd(out + i, _mm512_mul_pd(v, scale));
+    vp = _mm512_add_epi64(vp, vstep);
+  }
+  _mm256_zeroupper();
+  if (i < size) {
+    saw_scalar(out + i, size - i, phase + i * step, step);
+  }
+}
+
+OB_KERNEL_TARGET("avx512f")
+static void quantize_avx512(short* out, double const* in, std::size_t const size, double const gain) {
+  __m512d const vgain {_mm512_set1_pd(gain)};
+  __m512d const lo {_mm512_set1_pd(-32768.0)};
+  __m512d const hi {_mm512_set1_pd(32767.0)};
+  std::size_t i {0};
+  for (; i + 16 <= size; i += 16) {
+    __m256i const a {_mm512_cvttpd_epi32(_mm512_min_pd(_mm512_max_pd(_mm512_mul_pd(_mm512_loadu_pd(in + i), vgain), lo), hi))};
+    __m256i const b {_mm512_cvttpd_epi32(_mm512_min_pd(_mm512_max_pd(_mm512_mul_pd(_mm512_loadu_pd(in + i + 8), vgain), lo), hi))};
+    __m512i const v {_mm512_inserti64x4(_mm512_castsi256_si512(a), b, 1)};
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm512_cvtsepi32_epi16(v));
+  }
+  _mm256_zeroupper();
+  quantize_scalar(out + i, in + i, size - i, gain);
+}
+
+OB_KERNEL_TARGET("avx512f")
+static void spread_avx512(short* out, short const* in, std::size_t const size, std::uint16_t const left, std::uint16_t const right) {
+  __m512i const mask {_mm512_set1_epi32(static_cast<int>(left | (static_cast<std::uint32_t>(right) << 16)))};
+  std::size_t i {0};
+  for (; i + 16 <= size; i += 16) {
+    __m512i const v {_mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(in + i)))};
+    _mm512_storeu_si512(out + 2 * i, _mm512_and_si512(_mm512_or_si512(v, _mm512_slli_epi32(v, 16)), mask));
+  }
+  _mm256_zeroupper();
+  spread_scalar(out + 2 * i, in + i, size - i, left, right);
+}
+
+OB_KERNEL_TARGET("avx512f")
+static void round32_avx512(std::int32_t* out, double const* in, std::size_t const size, double const gain) {
+  __m512d const vgain {_mm512_set1_pd(gain)};
+  __m512d const lo {_mm512_set1_pd(-2147483648.0)};
+  __m512d const hi {_mm512_set1_pd(2147483647.0)};
+  std::size_t i {0};
+  for (; i + 8 <= size; i += 8) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm512_cvtpd_epi32(_mm512_min_pd(_mm512_max_pd(_mm512_mul_pd(_mm512_loadu_pd(in + i), vgain), lo), hi)));
+  }
+  _mm256_zeroupper();
+  round32_scalar(out + i, in + i, size - i, gain);
+}
+
+OB_KERNEL_TARGET("avx512f")
+static void narrow_avx512(float* out, double const* in, std::size_t const size, double const gain) {
+  __m512d const vgain {_mm512_set1_pd(gain)};
+  std::size_t i {0};
+  for (; i + 8 <= size; i += 8) {
+    _mm256_storeu_ps(out + i, _mm512_cvtpd_ps(_mm512_mul_pd(_mm512_loadu_pd(in + i), vgain)));
+  }
+  _mm256_zeroupper();
+  narrow_scalar(out + i, in + i, size - i, gain);
+}
+
+OB_KERNEL_TARGET("avx512f")
+static void spread32_avx512(std::uint32_t* out, std::uint32_t const* in, std::size_t const size, std::uint32_t const left, std::uint32_t const right) {
+  __m512i const mask {_mm512_set1_epi64(static_cast<long long>(left | (static_cast<std::uint64_t>(right) << 32)))};
+  std::size_t i {0};
+  for (; i + 8 <= size; i += 8) {
+    __m512i const v {_mm512_cvtepu32_epi64(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(in + i)))};
+    _mm512_storeu_si512(out + 2 * i, _mm512_and_si512(_mm512_or_si512(v, _mm512_slli_epi64(v, 32)), mask));
+  }
+  _mm256_zeroupper();
+  spread32_scalar(out + 2 * i, in + i, size - i, left, right);
+}
+
+OB_KERNEL_TARGET("avx512f")
+static void tpdf_avx512(double* out, std::size_t const size, std::uint32_t const key, std::uint32_t const counter) {
+  __m512i const step {_mm512_set1_epi32(16)};
+  __m512i const m1 {_mm512_set1_epi32(0x7feb352d)};
+  __m512i const m2 {_mm512_set1_epi32(static_cast<int>(0x846ca68bu))};
+  __m512i const low {_mm512_set1_epi32(0xffff)};
+  __m512i const bias {_mm512_set1_epi32(65535)};
+  __m512d const scale {_mm512_set1_pd(tpdf_scale)};
+  __m512i x {_mm512_add_epi32(_mm512_set1_epi32(static_cast<int>(counter + key)), _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15))};
+  std::size_t i {0};
+  for (; i + 16 <= size; i += 16) {
+    __m512i h {_mm512_xor_si512(x, _mm512_srli_epi32(x, 16))};
+    h = _mm512_mullo_epi32(h, m1);
+    h = _mm512_xor_si512(h, _mm512_srli_epi32(h, 15));
+    h = _mm512_mullo_epi32(h, m2);
+    h = _mm512_xor_si512(h, _mm512_srli_epi32(h, 16));
+    __m512i const s {_mm512_sub_epi32(_mm512_add_epi32(_mm512_and_si512(h, low), _mm512_srli_epi32(h, 16)), bias)};
+    _mm512_storeu_pd(out + i, _mm512_mul_pd(_mm512_cvtepi32_pd(_mm512_castsi512_si256(s)), scale));
+    _mm512_storeu_pd(out + i + 8, _mm512_mul_pd(_mm512_cvtepi32_pd(_mm512_extracti64x4_epi64(s, 1)), scale));
+    x = _mm512_add_epi32(x, step);
+  }
+  _mm256_zeroupper();
+  tpdf_scalar(out + i, size - i, key, static_cast<std::uint32_t>(counter + i));
+}
+
+OB_KERNEL_TARGET("avx512f")
+static __m512i hash32_avx512(__m512i x) {
+  x = _mm512_xor_si512(x, _mm512_srli_epi32(x, 16));
+  x = _mm512_mullo_epi32(x, _mm512_set1_epi32(0x7feb352d));
+  x = _mm512_xor_si512(x, _mm512_srli_epi32(x, 15));
+  x = _mm512_mullo_epi32(x, _mm512_set1_epi32(static_cast<int>(0x846ca68bu)));
+  return _mm512_xor_si512(x, _mm512_srli_epi32(x, 16));
+}
+
+OB_KERNEL_TARGET("avx512f")
+static void noise_avx512(double* out, std::size_t const size, std::uint32_t const* keys, double const* weights, std::size_t const rows, std::uint32_t const counter, bool const ramp) {
+  __m512i const one {_mm512_set1_epi32(1)};
+  __m512d const scale {_mm512_set1_pd(0x1p-31)};
+  __m512i frame {_mm512_add_epi32(_mm512_set1_epi32(static_cast<int>(counter)), _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15))};
+  std::size_t i {0};
+  for (; i + 16 <= size; i += 16) {
+    __m512d lo {_mm512_setzero_pd()};
+    __m512d hi {_mm512_setzero_pd()};
+    for (std::size_t k = 0; k < rows; ++k) {
+      __m512i const idx {_mm512_add_epi32(_mm512_set1_epi32(static_cast<int>(keys[k])), _mm512_srl_epi32(frame, _mm_cvtsi32_si128(static_cast<int>(k))))};
+      __m512i const h {hash32_avx512(idx)};
+      __m512d vlo {_mm512_mul_pd(_mm512_cvtepi32_pd(_mm512_castsi512_si256(h)), scale)};
+      __m512d vhi {_mm512_mul_pd(_mm512_cvtepi32_pd(_mm512_extracti64x4_epi64(h, 1)), scale)};
+      if (ramp && k) {
+        __m512i const next {hash32_avx512(_mm512_add_epi32(idx, one))};
+        __m512i const part {_mm512_and_si512(frame, _mm512_set1_epi32(static_cast<int>((std::uint32_t {1} << k) - 1)))};
+        __m512d const step {_mm512_set1_pd(std::ldexp(1.0, -static_cast<int>(k)))};
+        vlo = _mm512_add_pd(vlo, _mm512_mul_pd(_mm512_sub_pd(_mm512_mul_pd(_mm512_cvtepi32_pd(_mm512_castsi512_si256(next)), scale), vlo), _mm512_mul_pd(_mm512_cvtepi32_pd(_mm512_castsi512_si256(part)), step)));
+        vhi = _mm512_add_pd(vhi, _mm512_mul_pd(_mm512_sub_pd(_mm512_mul_pd(_mm512_cvtepi32_pd(_mm512_extracti64x4_epi64(next, 1)), scale), vhi), _mm512_mul_pd(_mm512_cvtepi32_pd(_mm512_extracti64x4_epi64(part, 1)), step)));
+      }
+      __m512d const weight {_mm512_set1_pd(weights[k])};
+      lo = _mm512_add_pd(lo, _mm512_mul_pd(weight, vlo));
+      hi = _mm512_add_pd(hi, _mm512_mul_pd(weight, vhi));
+    }
+    _mm512_storeu_pd(out + i, lo);
+    _mm512_storeu_pd(out + i + 8, hi);
+    frame = _mm512_add_epi32(frame, _mm512_set1_epi32(16));
+  }
+  _mm256_zeroupper();
+  noise_scalar(out + i, size - i, keys, weights, rows, static_cast<std::uint32_t>(counter + i), ramp);
+}
+
+// two steps of the grid fill a register, each spread over its four frames
+OB_KERNEL_TARGET("avx512f")
+static void expand_avx512(double* out, std::size_t const size, double const* coarse, std::size_t const offset, bool const ramp) {
+  std::size_t i {std::min(size, (4 - (offset & 3)) & 3)};
+  expand_scalar(out, i, coarse, offset, ramp);
+  __m512i const spread {_mm512_setr_epi64(0, 0, 0, 0, 1, 1, 1, 1)};
+  __m512d const frac {_mm512_setr_pd(0.0, 0.25, 0.5, 0.75, 0.0, 0.25, 0.5, 0.75)};
+  std::size_t j {(offset + i) >> 2};
+  for (; i + 8 <= size; i += 8, j += 2) {
+    __m128d const pair {_mm_loadu_pd(coarse + j)};
+    __m512d val {_mm512_permutexvar_pd(spread, _mm512_castpd128_pd512(pair))};
+    if (ramp) {
+      __m128d const slope {_mm_sub_pd(_mm_loadu_pd(coarse + j + 1), pair)};
+      val = _mm512_add_pd(val, _mm512_mul_pd(_mm512_permutexvar_pd(spread, _mm512_castpd128_pd512(slope)), frac));
+    }
+    _mm512_storeu_pd(out + i, _mm512_add_pd(_mm512_loadu_pd(out + i), val));
+  }
+  _mm256_zeroupper();
+  expand_scalar(out + i, size - i, coarse + j, 0, ramp);
+}
+
+OB_KERNEL_TARGET("avx512f")
+static void requantize_avx512(double* out, double const* in, double const* noise, std::size_t const size, double const gain, double const lo, double const hi) {
+  __m512d const vgain {_mm512_set1_pd(gain)};
+  __m512d const vlo {_mm512_set1_pd(lo)};
+  __m512d const vhi {_mm512_set1_pd(hi)};
+  __m512d const magic {_mm512_set1_pd(round_magic)};
+  std::size_t i {0};
+  for (; i + 8 <= size; i += 8) {
+    __m512d const v {_mm512_min_pd(_mm512_max_pd(_mm512_add_pd(_mm512_mul_pd(_mm512_loadu_pd(in + i), vgain), _mm512_loadu_pd(noise + i)), vlo), vhi)};
+    _mm512_storeu_pd(out + i, _mm512_sub_pd(_mm512_add_pd(v, magic), magic));
+  }
+  _mm256_zeroupper();
+  requantize_scalar(out + i, in + i, noise + i, size - i, gain, lo, hi);
+}
+
+OB_KERNEL_TARGET("avx512f")
+static void partials_avx512(double* out, std::size_t const size, double const* sine, double const* cosine, double const* amps, std::size_t const count) {
+  std::size_t i {0};
+  // four independent recurrences hide the latency of each step
+  for (; i + 32 <= size; i += 32) {
+    __m512d const c0 {_mm512_loadu_pd(cosine + i)};
+    __m512d const c1 {_mm512_loadu_pd(cosine + i + 8)};
+    __m512d const c2 {_mm512_loadu_pd(cosine + i + 16)};
+    __m512d const c3 {_mm512_loadu_pd(cosine + i + 24)};
+    __m512d const twice0 {_mm512_add_pd(c0, c0)};
+    __m512d const twice1 {_mm512_add_pd(c1, c1)};
+    __m512d const twice2 {_mm512_add_pd(c2, c2)};
+    __m512d const twice3 {_mm512_add_pd(c3, c3)};
+    __m512d prev0 {_mm512_setzero_pd()};
+    __m512d prev1 {_mm512_setzero_pd()};
+    __m512d prev2 {_mm512_setzero_pd()};
+    __m512d prev3 {_mm512_setzero_pd()};
+    __m512d cur0 {_mm512_loadu_pd(sine + i)};
+    __m512d cur1 {_mm512_loadu_pd(sine + i + 8)};
+    __m512d cur2 {_mm512_loadu_pd(sine + i + 16)};
+    __m512d cur3 {_mm512_loadu_pd(sine + i + 24)};
+    __m512d const amp {_mm512_set1_pd(amps[0])};
+    __m512d acc0 {_mm512_mul_pd(amp, cur0)};
+    __m512d acc1 {_mm512_mul_pd(amp, cur1)};
+    __m512d acc2 {_mm512_mul_pd(amp, cur2)};
+    __m512d acc3 {_mm512_mul_pd(amp, cur3)};
+    for (std::size_t k = 1; k < count; ++k) {
+      __m512d const gain {_mm512_set1_pd(amps[k])};
+      __m512d const next0 {_mm512_sub_pd(_mm512_mul_pd(twice0, cur0), prev0)};
+      __m512d const next1 {_mm512_sub_pd(_mm512_mul_pd(twice1, cur1), prev1)};
+      __m512d const next2 {_mm512_sub_pd(_mm512_mul_pd(twice2, cur2), prev2)};
+      __m512d const next3 {_mm512_sub_pd(_mm512_mul_pd(twice3, cur3), prev3)};
+      prev0 = cur0;
+      prev1 = cur1;
+      prev2 = cur2;
+      prev3 = cur3;
+      cur0 = next0;
+      cur1 = next1;
+      cur2 = next2;
+      cur3 = next3;
+      acc0 = _mm512_add_pd(acc0, _mm512_mul_pd(gain, cur0));
+      acc1 = _mm512_add_pd(acc1, _mm512_mul_pd(gain, cur1));
+      acc2 = _mm512_add_pd(acc2, _mm512_mul_pd(gain, cur2));
+      acc3 = _mm512_add_pd(acc3, _mm512_mul_pd(gain, cur3));
+    }
+    _mm512_storeu_pd(out + i, acc0);
+    _mm512_storeu_pd(out + i + 8, acc1);
+    _mm512_storeu_pd(out + i + 16, acc2);
+    _mm512_storeu_pd(out + i + 24, acc3);
+  }
+  _mm256_zeroupper();
+  partials_scalar(out + i, size - i, sine + i, cosine + i, amps, count);
+}
+
+OB_KERNEL_TARGET("avx512f")
+static void halfband_avx512(double* out, double const* even, double const* odd, std::size_t const size, double const* taps, std::size_t const count) {
+  __m512d const half {_mm512_set1_pd(0.5)};
+  std::size_t i {0};
+  // four independent sums hide the latency of the adds
+  for (; i + 32 <= size; i += 32) {
+    double const* lo {even + i + count - 1};
+    double const* hi {even + i + count};
+    __m512d acc0 {_mm512_setzero_pd()};
+    __m512d acc1 {_mm512_setzero_pd()};
+    __m512d acc2 {_mm512_setzero_pd()};
+    __m512d acc3 {_mm512_setzero_pd()};
+    for (std::size_t j = count; j-- > 0;) {
+      __m512d const tap {_mm512_set1_pd(taps[j])};
+      acc0 = _mm512_add_pd(acc0, _mm512_mul_pd(tap, _mm512_add_pd(_mm512_loadu_pd(lo - j), _mm512_loadu_pd(hi + j))));
+      acc1 = _mm512_add_pd(acc1, _mm512_mul_pd(tap, _mm512_add_pd(_mm512_loadu_pd(lo - j + 8), _mm512_loadu_pd(hi + j + 8))));
+      acc2 = _mm512_add_pd(acc2, _mm512_mul_pd(tap, _mm512_add_pd(_mm512_loadu_pd(lo - j + 16), _mm512_loadu_pd(hi + j + 16))));
+      acc3 = _mm512_add_pd(acc3, _mm512_mul_pd(tap, _mm512_add_pd(_mm512_loadu_pd(lo - j + 24), _mm512_loadu_pd(hi + j + 24))));
+    }
+    double const* mid {odd + i + count - 1};
+    _mm512_storeu_pd(out + i, _mm512_add_pd(acc0, _mm512_mul_pd(half, _mm512_loadu_pd(mid))));
+    _mm512_storeu_pd(out + i + 8, _mm512_add_pd(acc1, _mm512_mul_pd(half, _mm512_loadu_pd(mid + 8))));
+    _mm512_storeu_pd(out + i + 16, _mm512_add_pd(acc2, _mm512_mul_pd(half, _mm512_loadu_pd(mid + 16))));
+    _mm512_storeu_pd(out + i + 24, _mm512_add_pd(acc3, _mm512_mul_pd(half, _mm512_loadu_pd(mid + 24))));
+  }
+  _mm256_zeroupper();
+  halfband_scalar(out + i, even + i, odd + i, size - i, taps, count);
+}
+
+OB_KERNEL_TARGET("avx512f")
+static void polyphase_avx512(double* out, std::size_t const size, double const* in, double const* bank, std::size_t const taps, std::size_t const up, std::size_t const down, std::size_t phase) {
+  for (std::size_t i = 0; i < size; ++i) {
+    double const* x {in + phase / up};
+    double const* h {bank + (phase % up) * taps};
+    __m512d sum {_mm512_setzero_pd()};
+    for (std::size_t k = 0; k < taps; k += 8) {
+      sum = _mm512_add_pd(sum, _mm512_mul_pd(_mm512_loadu_pd(h + k), _mm512_loadu_pd(x + k)));
+    }
+    __m256d const t {_mm256_add_pd(_mm512_castpd512_pd256(sum), _mm512_extractf64x4_pd(sum, 1))};
+    __m128d const u {_mm_add_pd(_mm256_castpd256_pd128(t), _mm256_extractf128_pd(t, 1))};
+    out[i] = _mm_cvtsd_f64(_mm_add_sd(u, _mm_unpackhi_pd(u, u)));
+    phase += down;
+  }
+  _mm256_zeroupper();
+}
+
+#endif // OB_KERNEL_X86
+
+static Table const table_scalar {Isa::Scalar, sine_scalar, sine_poly_scalar, sine_table_scalar, modulate_scalar, feedback_scalar, lookup_scalar<lookup_bits>, partials_scalar, triangle_scalar, square_scalar, saw_scalar, quantize_scalar, spread_scalar, round32_scalar, narrow_scalar, spread32_scalar, pack24_scalar,
+  interleave_scalar<std::uint16_t>, interleave_scalar<std::uint32_t>, interleave_scalar<std::uint64_t>,
+  deinterleave_scalar<std::uint16_t>, deinterleave_scalar<std::uint32_t>, deinterleave_scalar<std::uint64_t>,
+  tpdf_scalar, noise_scalar, expand_scalar, requantize_scalar, shape_scalar, halfband_scalar, polyphase_scalar};
+#ifdef OB_KERNEL_X86
+// sse2 has no gather or byte shuffle, its table lookup and packing stay scalar,
+// and avx512f has no byte or word shuffles either but always comes with avx2
+static Table const table_sse2 {Isa::Sse2, sine_sse2, sine_poly_sse2, sine_table_scalar, modulate_sse2, feedback_scalar, lookup_scalar<lookup_bits>, partials_sse2, triangle_sse2, square_sse2, saw_sse2, quantize_sse2, spread_sse2, round32_sse2, narrow_sse2, spread32_sse2, pack24_scalar,
+  interleave16_sse2, interleave32_sse2, interleave64_sse2, deinterleave16_sse2, deinterleave32_sse2, deinterleave64_sse2,
+  tpdf_sse2, noise_sse2, expand_sse2, requantize_sse2, shape_sse2, halfband_sse2, polyphase_sse2};
+static Table const table_avx2 {Isa::Avx2, sine_avx2, sine_poly_avx2, sine_table_avx2, modulate_avx2, feedback_scalar, lookup_avx2<lookup_bits>, partials_avx2, triangle_avx2, square_avx2, saw_avx2, quantize_avx2, spread_avx2, round32_avx2, narrow_avx2, spread32_avx2, pack24_avx2,
+  interleave16_avx2, interleave32_avx2, interleave64_avx2, deinterleave16_avx2, deinterleave32_avx2, deinterleave64_avx2,
+  tpdf_avx2, noise_avx2, expand_avx2, requantize_avx2, shape_avx2, halfband_avx2, polyphase_avx2};
+static Table const table_avx512 {Isa::Avx512, sine_avx512, sine_poly_avx512, sine_table_avx512, modulate_avx512, feedback_scalar, lookup_avx512<lookup_bits>, partials_avx512, triangle_avx512, square_avx512, saw_avx512, quantize_avx512, spread_avx512, round32_avx512, narrow_avx512, spread32_avx512, pack24_avx2,
+  interleave16_avx2, interleave32_avx2, interleave64_avx2, deinterleave16_avx2, deinterleave32_avx2, deinterleave64_avx2,
+  tpdf_avx512, noise_avx512, expand_avx512, requantize_avx512, shape_avx2, halfband_avx512, polyphase_avx512};
+#endif // OB_KERNEL_X86
+
+static Table const* table_active {nullptr};
+
+Isa to_isa(std::string const& str) {
+  if (str == "scalar") {return Isa::Scalar;}
+  if (str == "sse2") {return Isa::Sse2;}
+  if (str == "avx2") {return Isa::Avx2;}
+  if (str == "avx512") {return Isa::Avx512;}
+  throw std::runtime_error("invalid kernel '" + str + "'");
+}
+
+std::string to_string(Isa const isa) {
+  switch (isa) {
+    case Isa::Sse2: return "sse2";
+    case Isa::Avx2: return "avx2";
+    case Isa::Avx512: return "avx512";
+    default: return "scalar";
+  }
+}
+
+Isa detect() {
+  for (auto const isa : {Isa::Avx512, Isa::Avx2, Isa::Sse2}) {
+    if (supported(isa)) {return isa;}
+  }
+  return Isa::Scalar;
+}
+
+bool supported(Isa const isa) {
+#ifdef OB_KERNEL_X86
+  __builtin_cpu_init();
+  switch (isa) {
+    case Isa::Sse2: return __builtin_cpu_supports("sse2");
+    case Isa::Avx2: return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    case Isa::Avx512: return __builtin_cpu_supports("avx512f");
+    default: return true;
+  }
+#else
+  return isa == Isa::Scalar;
+#endif
+}
+
+std::vector<std::pair<std::string, bool>> features() {
+  std::vector<std::pair<std::string, bool>> res;
+#ifdef OB_KERNEL_X86
+  __builtin_cpu_init();
+  res.emplace_back("sse2", __builtin_cpu_supports("sse2"));
+  res.emplace_back("avx", __builtin_cpu_supports("avx"));
+  res.emplace_back("avx2", __builtin_cpu_supports("avx2"));
+  res.emplace_back("fma", __builtin_cpu_supports("fma"));
+  res.emplace_back("avx512f", __builtin_cpu_supports("avx512f"));
+#endif
+  return res;
+}
+
+Table const& active() {
+  if (!table_active) {select(detect());}
+  return *table_active;
+}
+
+void select(Isa const isa) {
+  if (!supported(isa)) {
+    throw std::runtime_error("unsupported kernel '" + to_string(isa) + "'");
+  }
+  switch (isa) {
+#ifdef OB_KERNEL_X86
+    case Isa::Sse2: table_active = &table_sse2; break;
+    case Isa::Avx2: table_active = &table_avx2; break;
+    case Isa::Avx512: table_active = &table_avx512; break;
+#endif
+    default: table_active = &table_scalar; break;
+  }
+}
+
+} // namespace OB::Kernel
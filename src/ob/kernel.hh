@@ -0,0 +1,191 @@
+/*
+                                    88888888
+                                  888888888888
+                                 88888888888888
+                                8888888888888888
+                               888888888888888888
+                              888888  8888  888888
+                              88888    88    88888
+                              888888  8888  888888
+                              88888888888888888888
+                              88888888888888888888
+                             8888888888888888888888
+                          8888888888888888888888888888
+                        88888888888888888888888888888888
+                              88888888888888888888
+                            888888888888888888888888
+                           888888  8888888888  888888
+                           888     8888  8888     888
+                                   888    888
+
+                                   OCTOBANANA
+
+Licensed under the MIT License
+
+Copyright (c) 2020 Brett Robinson <https://octobanana.com/>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef OB_KERNEL_HH
+#define OB_KERNEL_HH
+
+#include <cstddef>
+#include <cstdint>
+
+#include <string>
+#include <vector>
+#include <utility>
+
+namespace OB::Kernel {
+
+// tables read by 'lookup' hold one cycle in 2^lookup_bits entries plus a
+// guard entry equal to the first
+static constexpr unsigned int lookup_bits {13};
+
+enum class Isa {
+  Scalar,
+  Sse2,
+  Avx2,
+  Avx512,
+};
+
+// Block kernels for one instruction set, the active table is chosen at
+// startup from the detected cpu features and can be overridden with 'select'.
+// The sine kernel runs a recurrence per lane and the sine_poly, sine_table,
+// modulate and lookup kernels of avx2 and avx512 use fused multiply-add, so
+// they may differ between instruction sets in the last bits, every other
+// kernel gives the same output on every instruction set.
+struct Table {
+  Isa isa {Isa::Scalar};
+
+  // out[i] = sin(x + i * w) given c = cos(x), s = sin(x), dc = cos(w), ds = sin(w)
+  void (*sine)(double* out, std::size_t const size, double const c, double const s, double const dc, double const ds) {nullptr};
+
+  // out[i] = sin(2 pi (phase + i * step)) of the 64-bit phase, by a minimax
+  // polynomial or by linear interpolation of a table
+  void (*sine_poly)(double* out, std::size_t const size, std::uint64_t const phase, std::uint64_t const step) {nullptr};
+  void (*sine_table)(double* out, std::size_t const size, std::uint64_t const phase, std::uint64_t const step) {nullptr};
+
+  // out[i] = sine_poly of the 64-bit phase + i * step advanced by
+  // depth * mod[i] cycles, rounded to 2^-32 of a cycle, for |depth| below
+  // 2^19, out may be the same buffer as mod
+  void (*modulate)(double* out, std::size_t const size, double const* mod, double const depth, std::uint64_t const phase, std::uint64_t const step) {nullptr};
+
+  // modulate of out by itself, out[i] is advanced by depth times the mean of
+  // out[i - 1] and out[i - 2], 'last' holds the two frames before the first
+  // and is left with the last two, newest first
+  void (*feedback)(double* out, std::size_t const size, double const depth, std::uint64_t const phase, std::uint64_t const step, double* last) {nullptr};
+
+  // out[i] = linear interpolation of 'table' at the 64-bit phase + i * step,
+  // indexed by its top lookup_bits
+  void (*lookup)(double* out, std::size_t const size, double const* table, std::uint64_t const phase, std::uint64_t const step) {nullptr};
+
+  // out[i] = sum of amps[k] * sin((k + 1) * x) for k < count, given sine[i] = sin(x)
+  // and cosine[i] = cos(x), by the Chebyshev recurrence
+  // sin((k + 1) * x) = 2 cos(x) sin(k * x) - sin((k - 1) * x), without fused
+  // multiply-add so every kernel gives the same result, 'count' is at least 1
+  void (*partials)(double* out, std::size_t const size, double const* sine, double const* cosine, double const* amps, std::size_t const count) {nullptr};
+
+  // piecewise-linear shapes of the 64-bit phase + i * step, using its top 32 bits
+  void (*triangle)(double* out, std::size_t const size, std::uint64_t const phase, std::uint64_t const step) {nullptr};
+  void (*square)(double* out, std::size_t const size, std::uint64_t const phase, std::uint64_t const step) {nullptr};
+  void (*saw)(double* out, std::size_t const size, std::uint64_t const phase, std::uint64_t const step) {nullptr};
+
+  // out[i] = in[i] * gain truncated toward zero and saturated to 16 bits
+  void (*quantize)(short* out, double const* in, std::size_t const size, double const gain) {nullptr};
+
+  // out[2 * i] = in[i] & left, out[2 * i + 1] = in[i] & right
+  void (*spread)(short* out, short const* in, std::size_t const size, std::uint16_t const left, std::uint16_t const right) {nullptr};
+
+  // out[i] = in[i] * gain rounded to nearest and saturated to 32 bits
+  void (*round32)(std::int32_t* out, double const* in, std::size_t const size, double const gain) {nullptr};
+
+  // out[i] = in[i] * gain rounded to single precision
+  void (*narrow)(float* out, double const* in, std::size_t const size, double const gain) {nullptr};
+
+  // spread of 32-bit samples, which are copied bit for bit
+  void (*spread32)(std::uint32_t* out, std::uint32_t const* in, std::size_t const size, std::uint32_t const left, std::uint32_t const right) {nullptr};
+
+  // packs the low 24 bits of each sample into 3 little endian bytes, out may
+  // be the same buffer as in
+  void (*pack24)(std::uint8_t* out, std::int32_t const* in, std::size_t const size) {nullptr};
+
+  // out[2 * i] = left[i], out[2 * i + 1] = right[i], for 16, 32 and 64-bit
+  // samples copied bit for bit
+  void (*interleave16)(std::uint16_t* out, std::uint16_t const* left, std::uint16_t const* right, std::size_t const size) {nullptr};
+  void (*interleave32)(std::uint32_t* out, std::uint32_t const* left, std::uint32_t const* right, std::size_t const size) {nullptr};
+  void (*interleave64)(std::uint64_t* out, std::uint64_t const* left, std::uint64_t const* right, std::size_t const size) {nullptr};
+
+  // left[i] = in[2 * i], right[i] = in[2 * i + 1]
+  void (*deinterleave16)(std::uint16_t* left, std::uint16_t* right, std::uint16_t const* in, std::size_t const size) {nullptr};
+  void (*deinterleave32)(std::uint32_t* left, std::uint32_t* right, std::uint32_t const* in, std::size_t const size) {nullptr};
+  void (*deinterleave64)(std::uint64_t* left, std::uint64_t* right, std::uint64_t const* in, std::size_t const size) {nullptr};
+
+  // triangular noise in (-1, 1) with a resolution of 2^-16, out[i] is a hash
+  // of 'counter' + 'key' + i, so any stretch of it can be generated on its own
+  void (*tpdf)(double* out, std::size_t const size, std::uint32_t const key, std::uint32_t const counter) {nullptr};
+
+  // out[i] = sum of weights[k] * row k at frame counter + i for k < rows, row k
+  // is a hash of keys[k] + (frame >> k) as a fraction in [-1, 1), held for
+  // its 2^k frames, or with 'ramp' running linearly to the next one over them,
+  // summed in the same order without fused multiply-add by every kernel
+  void (*noise)(double* out, std::size_t const size, std::uint32_t const* keys, double const* weights, std::size_t const rows, std::uint32_t const counter, bool const ramp) {nullptr};
+
+  // out[i] += coarse[j] for j = (offset + i) / 4, a grid of noise rows 4 times
+  // coarser held over its frames, or with 'ramp' running linearly to the next
+  // one as coarse[j] + (coarse[j + 1] - coarse[j]) * ((offset + i) % 4 / 4)
+  void (*expand)(double* out, std::size_t const size, double const* coarse, std::size_t const offset, bool const ramp) {nullptr};
+
+  // out[i] = round(clamp(in[i] * gain + noise[i], lo, hi)), with ties to even
+  void (*requantize)(double* out, double const* in, double const* noise, std::size_t const size, double const gain, double const lo, double const hi) {nullptr};
+
+  // requantize with error feedback of four runs at once, run k taking the
+  // frames k * stride + i for i < size, each from rest: with the last five
+  // errors e0 to e4, newest first, v = (in * gain - (c4 e4 + c3 e3 + c2 e2 +
+  // c1 e1)) - c0 e0, out = round(clamp(v + noise, lo, hi)) and the error fed
+  // back is clamp(out - v, -limit, limit), only frames from 'lead' on are
+  // written, so a run may read the frames the run before it writes
+  void (*shape)(double* out, double const* in, double const* noise, std::size_t const size, std::size_t const stride, std::size_t const lead, double const* coefs, double const gain, double const lo, double const hi, double const limit) {nullptr};
+
+  // out[i] = 0.5 * odd[i + count - 1] + sum of taps[j] * (even[i + count - 1 - j] + even[i + count + j])
+  // for j < count, the two phases of a half-band FIR decimating by 2, without
+  // fused multiply-add so every kernel gives the same result
+  void (*halfband)(double* out, double const* even, double const* odd, std::size_t const size, double const* taps, std::size_t const count) {nullptr};
+
+  // out[i] = sum of bank[p * taps + k] * in[q + k] for k < taps, where
+  // p = (phase + i * down) % up and q = (phase + i * down) / up, the filter
+  // bank of a rational resampler, 'taps' is a multiple of 8 and the products
+  // are summed in the same order by every kernel
+  void (*polyphase)(double* out, std::size_t const size, double const* in, double const* bank, std::size_t const taps, std::size_t const up, std::size_t const down, std::size_t phase) {nullptr};
+};
+
+Isa to_isa(std::string const& str);
+std::string to_string(Isa const isa);
+
+Isa detect();
+bool supported(Isa const isa);
+std::vector<std::pair<std::string, bool>> features();
+
+Table const& active();
+void select(Isa const isa);
+
+} // namespace OB::Kernel
+
+#endif // OB_KERNEL_HH
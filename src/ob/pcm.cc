@@ -0,0 +1,154 @@
+/*
+                                    88888888
+                                  888888888888
+                                 88888888888888
+                                8888888888888888
+                               888888888888888888
+                              888888  8888  888888
+                              88888    88    88888
+                              888888  8888  888888
+                              88888888888888888888
+                              88888888888888888888
+                             8888888888888888888888
+                          8888888888888888888888888888
+                        88888888888888888888888888888888
+                              88888888888888888888
+                            888888888888888888888888
+                           888888  8888888888  888888
+                           888     8888  8888     888
+                                   888    888
+
+                                   OCTOBANANA
+
+Licensed under the MIT License
+
+Copyright (c) 2020 Brett Robinson <https://octobanana.com/>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "ob/pcm.hh"
+#include "ob/kernel.hh"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+
+#include <string>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+
+namespace OB::Pcm {
+
+// size of the buffer, and of the pipe asked for
+static constexpr std::size_t buffer_size {std::size_t {1} << 20};
+
+Format to_format(std::string const& str) {
+  if (str == "s16le") {return Format::S16;}
+  if (str == "s24le") {return Format::S24;}
+  if (str == "s32le") {return Format::S32;}
+  if (str == "f32le") {return Format::F32;}
+  throw std::runtime_error("invalid format '" + str + "'");
+}
+
+std::string to_string(Format const format) {
+  switch (format) {
+    case Format::S24: return "s24le";
+    case Format::S32: return "s32le";
+    case Format::F32: return "f32le";
+    default: return "s16le";
+  }
+}
+
+std::size_t width(Format const format) {
+  switch (format) {
+    case Format::S24: return 3;
+    case Format::S32: return 4;
+    case Format::F32: return 4;
+    default: return 2;
+  }
+}
+
+double full_scale(Format const format) {
+  switch (format) {
+    case Format::S24: return 8388607.0;
+    case Format::S32: return 2147483647.0;
+    case Format::F32: return 1.0;
+    default: return 32767.0;
+  }
+}
+
+std::size_t encode(Format const format, void* data, std::size_t const size) {
+  if (format == Format::S24) {
+    OB::Kernel::active().pack24(static_cast<std::uint8_t*>(data), static_cast<std::int32_t const*>(data), size);
+    return size * 3;
+  }
+  std::size_t const bytes {width(format)};
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  char* const buf {static_cast<char*>(data)};
+  for (std::size_t i = 0; i < size * bytes; i += bytes) {
+    std::reverse(buf + i, buf + i + bytes);
+  }
+#endif
+
+  return size * bytes;
+}
+
+Writer::Writer(int const fd, std::size_t const frame, std::size_t const room) :
+  _fd {fd},
+  _frame {frame},
+  _room {std::max(frame, room)} {
+  if (!_frame) {
+    throw std::runtime_error("invalid frame size '" + std::to_string(_frame) + "'");
+  }
+
+#if defined(__linux__) && defined(F_SETPIPE_SZ)
+  struct stat st;
+  if (fstat(_fd, &st) == 0 && S_ISFIFO(st.st_mode)) {
+    // may be refused above the system limit, the pipe keeps its size then
+    fcntl(_fd, F_SETPIPE_SZ, static_cast<int>(buffer_size));
+  }
+#endif
+
+  _buf.resize(buffer_size - buffer_size % _room);
+}
+
+void Writer::commit(std::size_t const frames) {
+  write(_buf.data(), std::min(frames, this->frames()) * _frame);
+}
+
+void Writer::write(char const* data, std::size_t size) {
+  while (size) {
+    ssize_t const res {::write(_fd, data, size)};
+    if (res < 0) {
+      if (errno == EINTR) {continue;}
+      throw std::runtime_error("failed to write audio to the output");
+    }
+    data += res;
+    size -= static_cast<std::size_t>(res);
+  }
+}
+
+} // namespace OB::Pcm
@@ -0,0 +1,121 @@
+/*
+                                    88888888
+                                  888888888888
+                                 88888888888888
+                                8888888888888888
+                               888888888888888888
+                              888888  8888  888888
+                              88888    88    88888
+                              888888  8888  888888
+                              88888888888888888888
+                              88888888888888888888
+                             8888888888888888888888
+                          8888888888888888888888888888
+                        88888888888888888888888888888888
+                              88888888888888888888
+                            888888888888888888888888
+                           888888  8888888888  888888
+                           888     8888  8888     888
+                                   888    888
+
+                                   OCTOBANANA
+
+Licensed under the MIT License
+
+Copyright (c) 2020 Brett Robinson <https://octobanana.com/>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef OB_PCM_HH
+#define OB_PCM_HH
+
+#include <cstddef>
+
+#include <string>
+#include <vector>
+
+namespace OB::Pcm {
+
+// Sample formats of the output, all little endian.
+enum class Format {
+  S16,
+  S24,
+  S32,
+  F32,
+};
+
+Format to_format(std::string const& str);
+std::string to_string(Format const format);
+
+// bytes of an encoded sample
+std::size_t width(Format const format);
+
+// value a normalized sample of 1 is rendered as
+double full_scale(Format const format);
+
+// Encodes 'size' samples rendered for 'format', shorts for s16, 32-bit
+// integers for s24 and s32 and floats for f32, as little endian bytes in
+// place. The 24-bit samples are packed down from 32 bits, so the encoded size
+// in bytes is returned.
+std::size_t encode(Format const format, void* data, std::size_t const size);
+
+// Streams raw little endian samples to a file descriptor in large writes.
+// When the descriptor is a pipe it is grown to the size of the buffer, so a
+// write fills it in one go. The samples are copied into the pipe with write,
+// never mapped into it, so the reader may read, splice or tee them onward
+// and the buffer is free to be refilled as soon as commit returns. Frames of
+// 'frame' bytes are written, when they shrink in encoding 'room' is the size
+// they are rendered at.
+class Writer {
+public:
+  Writer(int const fd, std::size_t const frame, std::size_t const room = 0);
+  Writer(Writer&&) = default;
+  Writer(Writer const&) = delete;
+
+  ~Writer() = default;
+
+  Writer& operator=(Writer&&) = default;
+  Writer& operator=(Writer const&) = delete;
+
+  // capacity of the buffer in frames
+  std::size_t frames() const {
+    return _buf.size() / _room;
+  }
+
+  // buffer the next frames are rendered into
+  char* data() {
+    return _buf.data();
+  }
+
+  // writes the first 'frames' frames of the buffer
+  void commit(std::size_t const frames);
+
+private:
+  void write(char const* data, std::size_t size);
+
+  int _fd {-1};
+  std::size_t _frame {0};
+  std::size_t _room {0};
+  std::vector<char> _buf;
+};
+
+} // namespace OB::Pcm
+
+#endif // OB_PCM_HH
@@ -0,0 +1,128 @@
+/*
+                                    88888888
+                                  888888888888
+                                 88888888888888
+                                8888888888888888
+                               888888888888888888
+                              888888  8888  888888
+                              88888    88    88888
+                              888888  8888  888888
+                              88888888888888888888
+                              88888888888888888888
+                             8888888888888888888888
+                          8888888888888888888888888888
+                        88888888888888888888888888888888
+                              88888888888888888888
+                            888888888888888888888888
+                           888888  8888888888  888888
+                           888     8888  8888     888
+                                   888    888
+
+                                   OCTOBANANA
+
+Licensed under the MIT License
+
+Copyright (c) 2020 Brett Robinson <https://octobanana.com/>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef OB_RING_HH
+#define OB_RING_HH
+
+#include <cstddef>
+
+#include <atomic>
+#include <vector>
+#include <algorithm>
+
+namespace OB {
+
+// Single-producer single-consumer ring of trivially copyable values.
+// Each side owns one monotonic index and publishes it with a release store,
+// so neither side ever takes a lock or waits on the other.
+template<typename T>
+class Ring {
+public:
+  // the capacity is rounded up to a power of two
+  explicit Ring(std::size_t const capacity) :
+    _buf (ceil_pow2(capacity)),
+    _mask {_buf.size() - 1} {
+  }
+
+  Ring(Ring&&) = delete;
+  Ring(Ring const&) = delete;
+
+  ~Ring() = default;
+
+  Ring& operator=(Ring&&) = delete;
+  Ring& operator=(Ring const&) = delete;
+
+  std::size_t capacity() const {
+    return _buf.size();
+  }
+
+  // number of values ready to be read
+  std::size_t size() const {
+    return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+  }
+
+  // producer side, copies in up to 'size' values and returns how many fit
+  std::size_t push(T const* data, std::size_t size) {
+    std::size_t const head {_head.load(std::memory_order_relaxed)};
+    std::size_t const tail {_tail.load(std::memory_order_acquire)};
+    size = std::min(size, _buf.size() - (head - tail));
+    // at most two spans, split where the ring wraps
+    std::size_t const idx {head & _mask};
+    std::size_t const first {std::min(size, _buf.size() - idx)};
+    std::copy_n(data, first, _buf.data() + idx);
+    std::copy_n(data + first, size - first, _buf.data());
+    _head.store(head + size, std::memory_order_release);
+    return size;
+  }
+
+  // consumer side, copies out up to 'size' values and returns how many were read
+  std::size_t pop(T* data, std::size_t size) {
+    std::size_t const tail {_tail.load(std::memory_order_relaxed)};
+    std::size_t const head {_head.load(std::memory_order_acquire)};
+    size = std::min(size, head - tail);
+    std::size_t const idx {tail & _mask};
+    std::size_t const first {std::min(size, _buf.size() - idx)};
+    std::copy_n(_buf.data() + idx, first, data);
+    std::copy_n(_buf.data(), size - first, data + first);
+    _tail.store(tail + size, std::memory_order_release);
+    return size;
+  }
+
+private:
+  static std::size_t ceil_pow2(std::size_t const val) {
+    std::size_t res {1};
+    while (res < val) {res <<= 1;}
+    return res;
+  }
+
+  std::vector<T> _buf;
+  std::size_t const _mask;
+  alignas(64) std::atomic<std::size_t> _head {0};
+  alignas(64) std::atomic<std::size_t> _tail {0};
+};
+
+} // namespace OB
+
+#endif // OB_RING_HH
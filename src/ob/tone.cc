@@ -0,0 +1,993 @@
+/*
+                                    88888888
+                                  888888888888
+                                 88888888888888
+                                8888888888888888
+                               888888888888888888
+                              888888  8888  888888
+                              88888    88    88888
+                              888888  8888  888888
+                              88888888888888888888
+                              88888888888888888888
+                             8888888888888888888888
+                          8888888888888888888888888888
+                        88888888888888888888888888888888
+                              88888888888888888888
+                            888888888888888888888888
+                           888888  8888888888  888888
+                           888     8888  8888     888
+                                   888    888
+
+                                   OCTOBANANA
+
+Licensed under the MIT License
+
+Copyright (c) 2020 Brett Robinson <https://octobanana.com/>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "ob/tone.hh"
+#include "ob/kernel.hh"
+#include "ob/buffer.hh"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include <array>
+#include <string>
+#include <numeric>
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace OB::Tone {
+
+static double wrap(double const x) {
+  return x - std::floor(x);
+}
+
+// frame index as a double, indexes past 2^63 are taken as negative, where an
+// oversampled render reaches back before frame 0
+static double position(std::size_t const frame) {
+  return static_cast<double>(static_cast<std::int64_t>(frame));
+}
+
+// lowbias32 integer hash, spreads the seed and row over the keys
+static std::uint32_t mix(std::uint32_t x) {
+  x ^= x >> 16;
+  x *= 0x7feb352du;
+  x ^= x >> 15;
+  x *= 0x846ca68bu;
+  x ^= x >> 16;
+  return x;
+}
+
+Shape to_shape(std::string const& str) {
+  if (str == "sine") {return Shape::Sine;}
+  if (str == "triangle") {return Shape::Triangle;}
+  if (str == "square") {return Shape::Square;}
+  if (str == "saw") {return Shape::Saw;}
+  throw std::runtime_error("invalid wave '" + str + "'");
+}
+
+Phase to_phase(std::string const& str) {
+  if (str == "fixed") {return Phase::Fixed;}
+  if (str == "float") {return Phase::Float;}
+  throw std::runtime_error("invalid phase '" + str + "'");
+}
+
+Precision to_precision(std::string const& str) {
+  if (str == "exact") {return Precision::Exact;}
+  if (str == "polynomial") {return Precision::Polynomial;}
+  if (str == "table") {return Precision::Table;}
+  throw std::runtime_error("invalid precision '" + str + "'");
+}
+
+Color to_color(std::string const& str) {
+  if (str == "white") {return Color::White;}
+  if (str == "pink") {return Color::Pink;}
+  if (str == "brown") {return Color::Brown;}
+  throw std::runtime_error("invalid color '" + str + "'");
+}
+
+Antialias to_antialias(std::string const& str) {
+  if (str == "none") {return Antialias::None;}
+  if (str == "polyblep") {return Antialias::Polyblep;}
+  throw std::runtime_error("invalid antialias '" + str + "'");
+}
+
+// Residuals of the 2-point polynomial band-limited step of height 1 and ramp
+// of slope 1 per frame, at 'd' frames from the edge, d in (-1, 1).
+static double blep(double const d) {
+  return d < 0 ? 0.5 * (1.0 + d) * (1.0 + d) : -0.5 * (1.0 - d) * (1.0 - d);
+}
+
+static double blamp(double const d) {
+  double const x {d < 0 ? 1.0 + d : 1.0 - d};
+  return x * x * x / 6.0;
+}
+
+// An edge or corner of a shape, at a phase in cycles, with the jump in value
+// or the change in slope per cycle across it.
+struct Edge {
+  double phase;
+  double step;
+  bool corner;
+};
+
+template<Shape S>
+static constexpr std::array<Edge, 2> edges() {
+  if constexpr (S == Shape::Triangle) {
+    return {{{0.25, -8.0, true}, {0.75, 8.0, true}}};
+  }
+  else if constexpr (S == Shape::Square) {
+    return {{{0.0, 2.0, false}, {0.5, -2.0, false}}};
+  }
+  else {
+    // the saw has a single edge, the second entry is empty
+    return {{{0.5, -2.0, false}, {0.0, 0.0, false}}};
+  }
+}
+
+Wavetable::Wavetable(double const* cycle, std::size_t const frames, std::size_t const stride) {
+  if (frames < 2) {
+    throw std::runtime_error("invalid frames '" + std::to_string(frames) + "'");
+  }
+
+  // harmonics of the cycle by a direct dft, the nyquist bin of an even cycle
+  // has no phase and is left out
+  std::size_t const count {std::min(harmonics, (frames - 1) / 2)};
+  std::vector<double> cos_in (frames);
+  std::vector<double> sin_in (frames);
+  for (std::size_t i = 0; i < frames; ++i) {
+    cos_in[i] = std::cos(2.0 * M_PI * static_cast<double>(i) / static_cast<double>(frames));
+    sin_in[i] = std::sin(2.0 * M_PI * static_cast<double>(i) / static_cast<double>(frames));
+  }
+  std::vector<double> re (count + 1);
+  std::vector<double> im (count + 1);
+  for (std::size_t k = 1; k <= count; ++k) {
+    std::size_t idx {0};
+    for (std::size_t i = 0; i < frames; ++i) {
+      re[k] += cycle[i * stride] * cos_in[idx];
+      im[k] += cycle[i * stride] * sin_in[idx];
+      idx += k;
+      if (idx >= frames) {idx -= frames;}
+    }
+    re[k] *= 2.0 / static_cast<double>(frames);
+    im[k] *= 2.0 / static_cast<double>(frames);
+  }
+
+  // the levels are summed from the fundamental up, each one a snapshot of the
+  // partial sum, and the last level built is the first in the mip-map
+  std::vector<double> cos_out (size);
+  std::vector<double> sin_out (size);
+  for (std::size_t i = 0; i < size; ++i) {
+    cos_out[i] = std::cos(2.0 * M_PI * static_cast<double>(i) / static_cast<double>(size));
+    sin_out[i] = std::sin(2.0 * M_PI * static_cast<double>(i) / static_cast<double>(size));
+  }
+  std::vector<double> sum (size + 1);
+  double peak {0};
+  for (std::size_t top = 1, k = 1; top <= harmonics; top *= 2) {
+    for (; k <= std::min(top, count); ++k) {
+      for (std::size_t i = 0; i < size; ++i) {
+        std::size_t const idx {(k * i) & (size - 1)};
+        sum[i] += re[k] * cos_out[idx] + im[k] * sin_out[idx];
+      }
+    }
+    sum[size] = sum[0];
+    for (std::size_t i = 0; i < size; ++i) {
+      peak = std::max(peak, std::fabs(sum[i]));
+    }
+    _levels.emplace_back(sum);
+  }
+  std::reverse(_levels.begin(), _levels.end());
+
+  if (peak > 0) {
+    for (auto& level : _levels) {
+      for (auto& val : level) {
+        val /= peak;
+      }
+    }
+  }
+}
+
+double const* Wavetable::level(double const inc) const {
+  for (std::size_t i = 0; i < _levels.size(); ++i) {
+    if (static_cast<double>(harmonics >> i) * inc < 0.5) {
+      return _levels[i].data();
+    }
+  }
+  // even the fundamental is past nyquist
+  return _levels.back().data();
+}
+
+Accumulator::Accumulator(double const cycles, double const frames) {
+  // computed in extended precision where available to fill all 64 bits
+  long double const inc {static_cast<long double>(cycles) / static_cast<long double>(frames)};
+  long double const word {std::floor(std::ldexp(inc - std::floor(inc), 64) + 0.5L)};
+  _step = word < 0x1p64L ? static_cast<std::uint64_t>(word) : 0;
+}
+
+// phase step in cycles per frame, with Phase::Fixed at the quantized
+// frequency of the accumulator so the sine agrees with it
+static double increment(Accumulator const& acc, double const freq, double const frames, Phase const phase) {
+  return phase == Phase::Fixed ? Accumulator::cycles(acc.step()) : wrap(freq / frames);
+}
+
+// angle of a fundamental at a frame in radians
+static double angle(Accumulator const& acc, double const inc, Phase const phase, std::size_t const frame) {
+  return 2.0 * M_PI * (phase == Phase::Fixed ?
+    Accumulator::cycles(acc.at(frame)) : wrap(inc * position(frame)));
+}
+
+// decimator taking a tone rendered at 'oversample' times the rate back down,
+// none at the rate itself
+static std::shared_ptr<OB::Filter::Decimator const> decimator(std::size_t const oversample) {
+  if (oversample < 1) {
+    throw std::runtime_error("invalid oversample '" + std::to_string(oversample) + "'");
+  }
+  return oversample > 1 ? std::make_shared<OB::Filter::Decimator const>(oversample) : nullptr;
+}
+
+// renders the frame range by decimating what 'synth' renders at the factor
+// times the rate, a chunk of the renorm grid at a time
+template<typename F>
+static void oversample(OB::Filter::Decimator const& dec, F const& synth, double* out, std::size_t size, std::size_t start) {
+  std::size_t const factor {dec.factor()};
+  std::size_t const reach {dec.reach()};
+  // scratch is kept per thread across calls, jobs render at the same time
+  thread_local std::vector<double> buf;
+  buf.resize(std::max(buf.size(), dec.space(std::min(size, Oscillator::renorm))));
+  while (size) {
+    std::size_t const len {std::min(size, Oscillator::renorm)};
+    // the first frames of the tone wrap the start around below zero
+    synth(buf.data(), factor * (len - 1) + 2 * reach + 1, factor * start - reach);
+    dec.decimate(out, buf.data(), len);
+    out += len;
+    start += len;
+    size -= len;
+  }
+}
+
+Oscillator::Oscillator(Shape const shape, double const freq, int const rate, Phase const phase, Precision const precision, Antialias const antialias, std::size_t const oversample) :
+  _shape {shape},
+  _phase {phase},
+  _precision {precision},
+  _antialias {antialias},
+  _acc {freq, static_cast<double>(rate) * static_cast<double>(oversample)},
+  _inc {increment(_acc, freq, static_cast<double>(rate) * static_cast<double>(oversample), phase)},
+  _decimator {decimator(oversample)} {
+}
+
+void Oscillator::render(double* out, std::size_t size, std::size_t start) const {
+  if (!_decimator) {
+    synth(out, size, start);
+    return;
+  }
+  oversample(*_decimator, [this](double* buf, std::size_t const len, std::size_t const from) {synth(buf, len, from);}, out, size, start);
+}
+
+void Oscillator::synth(double* out, std::size_t size, std::size_t start) const {
+  switch (_shape) {
+    case Shape::Triangle: render<Shape::Triangle>(out, size, start); break;
+    case Shape::Square: render<Shape::Square>(out, size, start); break;
+    case Shape::Saw: render<Shape::Saw>(out, size, start); break;
+    default: render<Shape::Sine>(out, size, start); break;
+  }
+}
+
+template<Shape S>
+void Oscillator::render(double* out, std::size_t size, std::size_t start) const {
+  auto const& kernel {OB::Kernel::active()};
+  if constexpr (S == Shape::Sine) {
+    if (_precision == Precision::Exact) {
+      while (size) {
+        // chunks are aligned to the absolute renorm grid so that the output
+        // does not depend on how the caller splits the frame range
+        std::size_t const skip {start % renorm};
+        std::size_t const base {start - skip};
+        std::size_t const len {std::min(size, renorm - skip)};
+        sine(out, len, base, skip);
+        out += len;
+        start += len;
+        size -= len;
+      }
+      return;
+    }
+  }
+  if (_phase == Phase::Fixed) {
+    if constexpr (S == Shape::Sine) {
+      (_precision == Precision::Table ? kernel.sine_table : kernel.sine_poly)(out, size, _acc.at(start), _acc.step());
+    }
+    else if constexpr (S == Shape::Triangle) {
+      kernel.triangle(out, size, _acc.at(start), _acc.step());
+    }
+    else if constexpr (S == Shape::Square) {
+      kernel.square(out, size, _acc.at(start), _acc.step());
+    }
+    else {
+      kernel.saw(out, size, _acc.at(start), _acc.step());
+    }
+    if constexpr (S != Shape::Sine) {
+      if (_antialias == Antialias::Polyblep) {
+        polyblep<S>(out, size, start);
+      }
+    }
+  }
+  else {
+    for (std::size_t i = 0; i < size; ++i) {
+      double const phase {wrap(_inc * position(start + i))};
+      if constexpr (S == Shape::Sine) {
+        (_precision == Precision::Table ? kernel.sine_table : kernel.sine_poly)(out + i, 1, static_cast<std::uint64_t>(std::ldexp(phase, 64)), 0);
+      }
+      else if constexpr (S == Shape::Triangle) {
+        out[i] = 1.0 - 4.0 * std::fabs(wrap(phase + 0.25) - 0.5);
+      }
+      else if constexpr (S == Shape::Square) {
+        out[i] = phase < 0.5 ? 1.0 : -1.0;
+      }
+      else {
+        // split at the edge rather than shifting the phase, phase + 0.5 rounds
+        // onto 1.0 a frame before it
+        out[i] = phase < 0.5 ? 2.0 * phase : 2.0 * phase - 2.0;
+      }
+      if constexpr (S != Shape::Sine) {
+        if (_antialias == Antialias::Polyblep && _inc > 0) {
+          for (auto const& edge : edges<S>()) {
+            if (edge.step == 0) {continue;}
+            // frames from the nearest edge, only the two frames around it are within one
+            double const t {wrap(phase - edge.phase)};
+            double const d {t < _inc ? t / _inc : (t > 1.0 - _inc ? (t - 1.0) / _inc : 1.0)};
+            if (d < 1.0) {
+              out[i] += edge.corner ? edge.step * _inc * blamp(d) : edge.step * blep(d);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+template<Shape S>
+void Oscillator::polyblep(double* out, std::size_t const size, std::size_t const start) const {
+  std::uint64_t const step {_acc.step()};
+  if (!step) {return;}
+  double const inc {Accumulator::cycles(step)};
+  double const scale {1.0 / static_cast<double>(step)};
+  // crossings are either 'gap' or 'gap' + 1 frames apart
+  std::uint64_t const gap {~std::uint64_t {0} / step};
+  for (auto const& edge : edges<S>()) {
+    if (edge.step == 0) {continue;}
+    std::uint64_t const at {static_cast<std::uint64_t>(std::ldexp(edge.phase, 64))};
+    // the first frame less than one step past the edge, counted from 'start',
+    // and how far past it that frame is, in 64-bit phase
+    std::uint64_t past {_acc.at(start) - at};
+    std::uint64_t frame {0};
+    if (past >= step) {
+      std::uint64_t const ahead {~past + 1};
+      frame = (ahead - 1) / step + 1;
+      past = frame * step - ahead;
+    }
+    // every crossing up to one frame past the range still corrects its last frame
+    while (frame <= size) {
+      double const d {static_cast<double>(past) * scale};
+      double const after {edge.corner ? edge.step * inc * blamp(d) : edge.step * blep(d)};
+      double const before {edge.corner ? edge.step * inc * blamp(d - 1.0) : edge.step * blep(d - 1.0)};
+      if (frame < size) {
+        out[frame] += after;
+      }
+      if (frame > 0) {
+        out[frame - 1] += before;
+      }
+      // frames to the next crossing, ceil((2^64 - past) / step), which is
+      // 'gap' when that many steps already wrap past the edge
+      std::uint64_t const next {gap * step + past < past ? gap : gap + 1};
+      if (next > size + 1 - frame) {break;}
+      frame += next;
+      past = past + next * step;
+    }
+  }
+}
+
+void Oscillator::sine(double* out, std::size_t const size, std::size_t const base, std::size_t const skip) const {
+  if (skip) {
+    // vector kernels interleave lanes from the chunk base, so render the
+    // whole chunk to keep the output independent of the split point
+    double chunk[renorm];
+    sine(chunk, skip + size, base, 0);
+    std::copy(chunk + skip, chunk + skip + size, out);
+    return;
+  }
+
+  double const phase {angle(_acc, _inc, _phase, base)};
+  OB::Kernel::active().sine(out, size, std::cos(phase), std::sin(phase), std::cos(2.0 * M_PI * _inc), std::sin(2.0 * M_PI * _inc));
+}
+
+
+Lookup::Lookup(std::shared_ptr<Wavetable const> const& table, double const freq, int const rate, Phase const phase) :
+  _phase {phase},
+  _acc {freq, static_cast<double>(rate)},
+  _inc {increment(_acc, freq, static_cast<double>(rate), phase)},
+  _table {table},
+  _level {_table->level(_inc)} {
+}
+
+void Lookup::render(double* out, std::size_t const size, std::size_t const start) const {
+  auto const& kernel {OB::Kernel::active()};
+  if (_phase == Phase::Fixed) {
+    kernel.lookup(out, size, _level, _acc.at(start), _acc.step());
+    return;
+  }
+  for (std::size_t i = 0; i < size; ++i) {
+    double const phase {wrap(_inc * position(start + i))};
+    kernel.lookup(out + i, 1, _level, static_cast<std::uint64_t>(std::ldexp(phase, 64)), 0);
+  }
+}
+
+
+Additive::Additive(std::size_t const harmonics, double const rolloff, double const freq, int const rate, Phase const phase, std::size_t const oversample) :
+  _phase {phase},
+  _acc {freq, static_cast<double>(rate) * static_cast<double>(oversample)},
+  _inc {increment(_acc, freq, static_cast<double>(rate) * static_cast<double>(oversample), phase)},
+  _decimator {decimator(oversample)} {
+  if (harmonics < 1) {
+    throw std::runtime_error("invalid harmonics '" + std::to_string(harmonics) + "'");
+  }
+  if (!std::isfinite(rolloff)) {
+    throw std::runtime_error("invalid rolloff '" + std::to_string(rolloff) + "'");
+  }
+
+  // partials at or past nyquist of the output rate are left out
+  double const cycles {std::fabs(freq) / static_cast<double>(rate)};
+  std::vector<double> amps;
+  for (std::size_t k = 1; k <= harmonics && static_cast<double>(k) * cycles < 0.5; ++k) {
+    amps.emplace_back(std::pow(static_cast<double>(k), -rolloff));
+  }
+
+  // the peak is found on a grid of 16 points to a period of the top partial,
+  // summed by the same kernel as the tone
+  if (amps.size()) {
+    std::size_t const grid {16 * amps.size()};
+    std::vector<double> sine (grid);
+    std::vector<double> cosine (grid);
+    std::vector<double> sum (grid);
+    for (std::size_t i = 0; i < grid; ++i) {
+      sine[i] = std::sin(2.0 * M_PI * static_cast<double>(i) / static_cast<double>(grid));
+      cosine[i] = std::cos(2.0 * M_PI * static_cast<double>(i) / static_cast<double>(grid));
+    }
+    OB::Kernel::active().partials(sum.data(), grid, sine.data(), cosine.data(), amps.data(), amps.size());
+    std::size_t top {0};
+    for (std::size_t i = 0; i < grid; ++i) {
+      if (std::fabs(sum[i]) > std::fabs(sum[top])) {top = i;}
+    }
+    // and refined between the grid points around the highest one
+    double peak {std::fabs(sum[top])};
+    for (std::size_t j = 1; j < 64; ++j) {
+      double const x {2.0 * M_PI * (static_cast<double>(top) - 1.0 + static_cast<double>(j) / 32.0) / static_cast<double>(grid)};
+      double val {0};
+      for (std::size_t k = 0; k < amps.size(); ++k) {
+        val += amps[k] * std::sin(static_cast<double>(k + 1) * x);
+      }
+      peak = std::max(peak, std::fabs(val));
+    }
+    if (peak > 0) {
+      for (auto& amp : amps) {
+        amp /= peak;
+      }
+    }
+  }
+  _partials = std::make_shared<std::vector<double> const>(std::move(amps));
+}
+
+void Additive::render(double* out, std::size_t size, std::size_t start) const {
+  if (!_decimator) {
+    synth(out, size, start);
+    return;
+  }
+  oversample(*_decimator, [this](double* buf, std::size_t const len, std::size_t const from) {synth(buf, len, from);}, out, size, start);
+}
+
+void Additive::synth(double* out, std::size_t size, std::size_t start) const {
+  auto const& partials {*_partials};
+  if (partials.empty()) {
+    // even the fundamental is past nyquist
+    std::fill_n(out, size, 0.0);
+    return;
+  }
+  auto const& kernel {OB::Kernel::active()};
+  double const dc {std::cos(2.0 * M_PI * _inc)};
+  double const ds {std::sin(2.0 * M_PI * _inc)};
+  double sine[Oscillator::renorm];
+  double cosine[Oscillator::renorm];
+  while (size) {
+    // the fundamental is rendered over whole chunks of the renorm grid, as
+    // the sine is, with its cosine a quarter cycle ahead of it
+    std::size_t const skip {start % Oscillator::renorm};
+    std::size_t const base {start - skip};
+    std::size_t const len {std::min(size, Oscillator::renorm - skip)};
+    double const phase {angle(_acc, _inc, _phase, base)};
+    double const c {std::cos(phase)};
+    double const s {std::sin(phase)};
+    kernel.sine(sine, skip + len, c, s, dc, ds);
+    kernel.sine(cosine, skip + len, -s, c, dc, ds);
+    kernel.partials(out, len, sine + skip, cosine + skip, partials.data(), partials.size());
+    out += len;
+    start += len;
+    size -= len;
+  }
+}
+
+
+Fm::Fm(std::vector<double> const& ratios, std::vector<double> const& indexes, double const feedback, double const freq, int const rate, Phase const phase, std::size_t const oversample) :
+  _phase {phase},
+  _decimator {decimator(oversample)} {
+  if (ratios.empty() || indexes.size() + 1 != ratios.size()) {
+    throw std::runtime_error("invalid operators '" + std::to_string(ratios.size()) + "' for '" + std::to_string(indexes.size()) + "' indexes");
+  }
+  // the modulate kernel takes deviations below 2^19 cycles
+  auto const deviation = [](double const radians) {
+    return std::isfinite(radians) && std::fabs(radians) < 0x1p19 * M_PI;
+  };
+  if (!deviation(feedback)) {
+    throw std::runtime_error("invalid feedback '" + std::to_string(feedback) + "'");
+  }
+
+  double const frames {static_cast<double>(rate) * static_cast<double>(oversample)};
+  std::vector<Operator> ops;
+  for (std::size_t i = 0; i < ratios.size(); ++i) {
+    if (!(ratios[i] > 0) || std::isinf(ratios[i])) {
+      throw std::runtime_error("invalid ratio '" + std::to_string(ratios[i]) + "'");
+    }
+    double const index {i ? indexes[i - 1] : 0.0};
+    if (!deviation(index)) {
+      throw std::runtime_error("invalid index '" + std::to_string(index) + "'");
+    }
+    Accumulator const acc {freq * ratios[i], frames};
+    ops.emplace_back(Operator {acc, increment(acc, freq * ratios[i], frames, phase), index / (2.0 * M_PI)});
+  }
+  _operators = std::make_shared<std::vector<Operator> const>(std::move(ops));
+  _feedback = feedback / (2.0 * M_PI);
+  double const period {std::ceil(frames / (freq * ratios.back()))};
+  _lead = warmup + (period >= 0 && period < static_cast<double>(reach) ? static_cast<std::size_t>(period) : reach);
+}
+
+void Fm::render(double* out, std::size_t size, std::size_t start) const {
+  if (!_decimator) {
+    synth(out, size, start);
+    return;
+  }
+  oversample(*_decimator, [this](double* buf, std::size_t const len, std::size_t const from) {synth(buf, len, from);}, out, size, start);
+}
+
+void Fm::synth(double* out, std::size_t size, std::size_t start) const {
+  auto const& ops {*_operators};
+  // scratch is kept per thread across calls, jobs render at the same time
+  thread_local std::vector<double> buf;
+  buf.resize(std::max(buf.size(), _lead + Oscillator::renorm));
+  while (size) {
+    std::size_t const skip {start % Oscillator::renorm};
+    std::size_t const len {std::min(size, Oscillator::renorm - skip)};
+    double* mod {buf.data()};
+    if (_feedback != 0) {
+      // the feedback loop runs from '_lead' frames before the chunk, its
+      // error from the cold start is gone by the first frame of it
+      feedback(buf.data(), _lead + skip + len, start - skip - _lead);
+      mod = buf.data() + _lead + skip;
+    }
+    else {
+      modulate(ops.back(), mod, len, nullptr, 0, start);
+    }
+    // down the stack to the carrier, each operator in place of the one above it
+    for (std::size_t i = ops.size() - 1; i-- > 0;) {
+      modulate(ops[i], i ? mod : out, len, mod, ops[i + 1].depth, start);
+    }
+    if (ops.size() == 1) {
+      std::copy_n(mod, len, out);
+    }
+    out += len;
+    start += len;
+    size -= len;
+  }
+}
+
+void Fm::reference(double* out, std::size_t const size) const {
+  auto const& ops {*_operators};
+  std::vector<double> buf (_lead + size);
+  double* const mod {buf.data() + _lead};
+  if (_feedback != 0) {
+    // frame 0 wraps around below zero as the first chunk does
+    feedback(buf.data(), _lead + size, std::size_t {0} - _lead);
+  }
+  else {
+    modulate(ops.back(), mod, size, nullptr, 0, 0);
+  }
+  for (std::size_t i = ops.size() - 1; i-- > 0;) {
+    modulate(ops[i], i ? mod : out, size, mod, ops[i + 1].depth, 0);
+  }
+  if (ops.size() == 1) {
+    std::copy_n(mod, size, out);
+  }
+}
+
+// the top operator modulating itself over the frame range, from rest
+void Fm::feedback(double* out, std::size_t const size, std::size_t const from) const {
+  auto const& kernel {OB::Kernel::active()};
+  auto const& top {_operators->back()};
+  double last[2] {0, 0};
+  if (_phase == Phase::Fixed) {
+    kernel.feedback(out, size, _feedback, top.acc.at(from), top.acc.step(), last);
+    return;
+  }
+  for (std::size_t i = 0; i < size; ++i) {
+    kernel.feedback(out + i, 1, _feedback, static_cast<std::uint64_t>(std::ldexp(wrap(top.inc * position(from + i)), 64)), 0, last);
+  }
+}
+
+// one operator of the fm stack over the frame range, modulated by 'mod'
+// scaled by 'depth' cycles, or unmodulated without it
+void Fm::modulate(Operator const& op, double* out, std::size_t const size, double const* mod, double const depth, std::size_t const start) const {
+  auto const& kernel {OB::Kernel::active()};
+  if (_phase == Phase::Fixed) {
+    if (mod) {
+      kernel.modulate(out, size, mod, depth, op.acc.at(start), op.acc.step());
+    }
+    else {
+      kernel.sine_poly(out, size, op.acc.at(start), op.acc.step());
+    }
+    return;
+  }
+  for (std::size_t i = 0; i < size; ++i) {
+    auto const phase {static_cast<std::uint64_t>(std::ldexp(wrap(op.inc * position(start + i)), 64))};
+    if (mod) {
+      kernel.modulate(out + i, 1, mod + i, depth, phase, 0);
+    }
+    else {
+      kernel.sine_poly(out + i, 1, phase, 0);
+    }
+  }
+}
+
+
+// rows of noise rendered per level of the grid, each level steps
+// 'level_span' times slower than the one before it, the span the expand
+// kernel spreads a level over
+static constexpr std::size_t level_rows {2};
+static constexpr std::size_t level_span {std::size_t {1} << level_rows};
+
+// frames rendered at a time, long enough that the levels of the coarsest
+// rows are still worth a kernel call, and the room their grids take, each
+// a quarter of the one before it plus the frames a ramp runs into
+static constexpr std::size_t level_chunk {std::size_t {1} << 14};
+static constexpr std::size_t level_room {level_chunk / (level_span - 1) + 4 * Noise::rows};
+
+Noise::Noise(Color const color, std::uint32_t const seed) :
+  _seed {seed},
+  _ramp {color == Color::Brown} {
+  std::vector<double> weights (color == Color::White ? 1 : rows);
+  for (std::size_t k = 0; k < weights.size(); ++k) {
+    weights[k] = color == Color::Brown ? std::sqrt(std::ldexp(1.0, static_cast<int>(k))) : 1.0;
+  }
+  // every row is within [-1, 1], so is their sum scaled by the total weight
+  double const total {std::accumulate(weights.begin(), weights.end(), 0.0)};
+  for (auto& weight : weights) {
+    weight /= total;
+  }
+  _weights = std::make_shared<std::vector<double> const>(std::move(weights));
+}
+
+void Noise::render(double* out, std::size_t size, std::size_t start) const {
+  auto const& weights {*_weights};
+  auto const key = [this](std::uint32_t const row, std::uint32_t const high) {
+    return mix(mix(_seed) ^ mix(row ^ mix(high)));
+  };
+  std::array<std::uint32_t, rows> keys {};
+  // scratch is kept per thread across calls, jobs render at the same time
+  thread_local std::vector<double> grid;
+  grid.resize(std::max(grid.size(), level_room));
+  while (size) {
+    // the kernel counts frames in 32 bits, the rest of the frame goes into
+    // the keys, row k steps 2^(32 - k) times per 2^32 frames so its key moves
+    // on by as many and a ramp runs on into the next stretch, the first row
+    // never ramps and hashes the rest of the frame instead
+    std::uint32_t const counter {static_cast<std::uint32_t>(start)};
+    std::uint64_t const high {static_cast<std::uint64_t>(start) >> 32};
+    std::size_t const len {static_cast<std::size_t>(std::min<std::uint64_t>(size, (std::uint64_t {1} << 32) - counter))};
+    keys[0] = key(0, static_cast<std::uint32_t>(high));
+    for (std::size_t k = 1; k < weights.size(); ++k) {
+      keys[k] = key(static_cast<std::uint32_t>(k), 0) + static_cast<std::uint32_t>(high << (32 - k));
+    }
+    for (std::size_t i = 0; i < len; i += level_chunk) {
+      render(out + i, std::min(level_chunk, len - i), static_cast<std::uint32_t>(counter + i), keys.data(), weights.data(), weights.size(), grid.data());
+    }
+    out += len;
+    start += len;
+    size -= len;
+  }
+}
+
+
+void Noise::render(double* out, std::size_t const size, std::uint32_t const counter, std::uint32_t const* keys, double const* weights, std::size_t const count, double* grid) const {
+  auto const& kernel {OB::Kernel::active()};
+  std::size_t const fine {std::min<std::size_t>(count, level_rows)};
+  kernel.noise(out, size, keys, weights, fine, counter, _ramp);
+  if (count == fine) {return;}
+
+  // the coarse grid holds the frames at multiples of 'level_span', a ramp
+  // also needs the one after the last
+  std::uint32_t const first {counter >> level_rows};
+  std::uint32_t const last {static_cast<std::uint32_t>((counter + (size - 1)) >> level_rows)};
+  double* const coarse {grid};
+  std::size_t const span {last - first + (_ramp ? 2 : 1)};
+  render(coarse, span, first, keys + fine, weights + fine, count - fine, grid + span);
+  kernel.expand(out, size, coarse, counter & (level_span - 1), _ramp);
+}
+
+
+// converts normalized samples, 16-bit output is truncated as it always has
+// been, 32-bit output is rounded, both saturate
+static void convert(short* out, double const* in, std::size_t const size, double const gain) {
+  OB::Kernel::active().quantize(out, in, size, gain);
+}
+
+static void convert(std::int32_t* out, double const* in, std::size_t const size, double const gain) {
+  OB::Kernel::active().round32(out, in, size, gain);
+}
+
+static void convert(float* out, double const* in, std::size_t const size, double const gain) {
+  OB::Kernel::active().narrow(out, in, size, gain);
+}
+
+// fans mono frames out to the two sides of a stereo layout
+static void spread(short* out, short const* in, std::size_t const size, Layout const& layout) {
+  OB::Kernel::active().spread(out, in, size, static_cast<std::uint16_t>(layout.left ? 0xffff : 0), static_cast<std::uint16_t>(layout.right ? 0xffff : 0));
+}
+
+template<typename T>
+static void spread(T* out, T const* in, std::size_t const size, Layout const& layout) {
+  static_assert(sizeof(T) == sizeof(std::uint32_t));
+  // a masked out float is +0.0
+  OB::Kernel::active().spread32(reinterpret_cast<std::uint32_t*>(out), reinterpret_cast<std::uint32_t const*>(in), size, layout.left ? 0xffffffffu : 0u, layout.right ? 0xffffffffu : 0u);
+}
+
+Tape::Tape(Generator const& gen) :
+  _gen {gen} {
+}
+
+double* Tape::record(std::size_t const start, std::size_t const size) {
+  _start = start;
+  _frames.resize(size);
+  return _frames.data();
+}
+
+void Tape::render(double* out, std::size_t const size, std::size_t const start) const {
+  // offsets wrap like the frames do
+  std::size_t const offset {start - _start};
+  if (size <= _frames.size() && offset <= _frames.size() - size) {
+    std::copy_n(_frames.data() + offset, size, out);
+    return;
+  }
+  _gen(out, size, start);
+}
+
+Resample::Resample(Generator const& gen, int const from, int const to) :
+  _gen {gen},
+  _resampler {std::make_shared<OB::Filter::Resampler const>(from, to)} {
+}
+
+void Resample::render(double* out, std::size_t const size, std::size_t const start) const {
+  if (!size) {return;}
+  std::size_t const span {_resampler->span(start, size)};
+  // scratch is kept per thread across calls, jobs render at the same time,
+  // the generator reads the tape and never resamples on this thread itself
+  thread_local std::vector<double> buf;
+  buf.resize(std::max(buf.size(), span));
+  _gen(buf.data(), span, _resampler->first(start));
+  _resampler->render(out, size, start, buf.data());
+}
+
+template<typename T>
+Source<T>::Source(Oscillator const& osc, double const gain, std::size_t const size, Layout const& layout, std::size_t const period, OB::Dither::Quantizer const& quant) :
+  Source {Generator {[osc](double* out, std::size_t const frames, std::size_t const start) {osc.render(out, frames, start);}}, gain, size, layout, period, quant} {
+}
+
+template<typename T>
+Source<T>::Source(Generator const& gen, double const gain, std::size_t const size, Layout const& layout, std::size_t const period, OB::Dither::Quantizer const& quant) :
+  _gen {gen},
+  _gain {gain},
+  _size {size},
+  _layout {layout},
+  _period {quant.active() ? 0 : period},
+  _quant {quant} {
+  if (_layout.channels < 1 || _layout.channels > 2) {
+    throw std::runtime_error("invalid channels '" + std::to_string(_layout.channels) + "'");
+  }
+  if (_period) {
+    _tile.resize(_period * _layout.channels);
+    synth(_tile.data(), _period, 0);
+  }
+}
+
+template<typename T>
+std::size_t Source<T>::render(T* out, std::size_t size) {
+  size = std::min(size, _size - _pos);
+  render(out, size, _pos);
+  _pos += size;
+  return size;
+}
+
+template<typename T>
+void Source<T>::render(T* out, std::size_t size, std::size_t start) const {
+  if (!_period) {
+    synth(out, size, start);
+    return;
+  }
+  std::size_t const channels {_layout.channels};
+  while (size) {
+    std::size_t const offset {start % _period};
+    std::size_t const len {std::min(size, _period - offset)};
+    std::copy_n(_tile.data() + offset * channels, len * channels, out);
+    out += len * channels;
+    start += len;
+    size -= len;
+  }
+}
+
+template<typename T>
+void Source<T>::synth(T* out, std::size_t size, std::size_t start) const {
+  if (_quant.active()) {
+    dither(out, size, start);
+    return;
+  }
+  double samples[Oscillator::renorm];
+  T frames[Oscillator::renorm];
+  while (size) {
+    // blocks follow the renorm grid so the oscillator never renders a chunk twice
+    std::size_t const len {std::min(size, Oscillator::renorm - start % Oscillator::renorm)};
+    _gen(samples, len, start);
+    if (_layout.channels == 1) {
+      convert(out, samples, len, _gain);
+    }
+    else {
+      convert(frames, samples, len, _gain);
+      spread(out, frames, len, _layout);
+    }
+    out += len * _layout.channels;
+    start += len;
+    size -= len;
+  }
+}
+
+template<typename T>
+void Source<T>::dither(T* out, std::size_t size, std::size_t start) const {
+  using Quantizer = OB::Dither::Quantizer;
+  std::size_t const lead {_quant.history()};
+  // runs cover as many pieces of the shaping grid as the quantizer shapes
+  // side by side
+  std::size_t const span {Quantizer::lanes * Quantizer::span};
+  // scratch is kept per thread across calls, jobs render at the same time
+  thread_local std::vector<double> samples;
+  thread_local std::vector<double> steps;
+  thread_local std::vector<T> planes;
+  samples.resize(std::max(samples.size(), span + Quantizer::warmup));
+  steps.resize(std::max(steps.size(), span + Quantizer::warmup));
+  planes.resize(std::max(planes.size(), 2 * span));
+  std::size_t const channels {_layout.channels};
+  while (size) {
+    std::size_t const offset {start % Quantizer::span};
+    std::size_t const len {std::min(size, span - offset)};
+    // a shaped piece always starts its filter the same frames ahead of it, so
+    // it comes out the same however the range is split
+    std::size_t const from {lead ? start - offset - std::min(start - offset, lead) : start};
+    std::size_t const count {start + len - from};
+    _gen(samples.data(), count, from);
+    for (std::size_t c = 0; c < channels; ++c) {
+      T* const plane {channels == 1 ? out : planes.data() + c * span};
+      if (channels == 2 && !(c == 0 ? _layout.left : _layout.right)) {
+        std::fill_n(plane, len, T {});
+        continue;
+      }
+      _quant.apply(steps.data(), samples.data(), count, from, c, _gain);
+      // the samples are whole steps in range, so converting them is exact
+      convert(plane, steps.data() + (start - from), len, 1.0);
+    }
+    if (channels == 2) {
+      T const* const sides[2] {planes.data(), planes.data() + span};
+      OB::interleave(out, sides, 2, len);
+    }
+    out += len * channels;
+    start += len;
+    size -= len;
+  }
+}
+
+template class Source<short>;
+template class Source<std::int32_t>;
+template class Source<float>;
+
+std::size_t period(double const freq, int const rate, std::size_t const limit) {
+  if (!(freq > 0) || rate <= 0) {return 0;}
+  for (std::uint64_t den = 1; den <= 1000; den *= 10) {
+    double const num {std::round(freq * static_cast<double>(den))};
+    if (num > 0x1p53 || std::fabs(num - freq * static_cast<double>(den)) > 1e-9 * num) {continue;}
+    // freq / rate = num / (den * rate) cycles per frame, reduced to lowest terms
+    std::uint64_t const frames {den * static_cast<std::uint64_t>(rate)};
+    std::uint64_t const res {frames / std::gcd(static_cast<std::uint64_t>(num), frames)};
+    return res <= limit ? static_cast<std::size_t>(res) : 0;
+  }
+  return 0;
+}
+
+Loop loop(double const freq, int const rate, std::size_t const limit, double const tolerance) {
+  Loop res;
+  if (!(freq > 0) || rate <= 0) {return res;}
+  long double const frames {static_cast<long double>(rate) / freq};
+  res.error = 1;
+  for (std::size_t cycles = 1;; ++cycles) {
+    long double const len {std::round(frames * cycles)};
+    if (len > limit) {break;}
+    if (len < 1) {continue;}
+    // phase of the frame after the loop, in cycles away from the start
+    double const error {static_cast<double>(std::fabs(len / frames - cycles))};
+    if (error < res.error) {
+      res.frames = static_cast<std::size_t>(len);
+      res.error = error;
+      if (error <= tolerance) {break;}
+    }
+  }
+  return res;
+}
+
+double analytic(Shape const shape, double const phase) {
+  double const cycle {phase - std::floor(phase)};
+  long double const x {2.0L * static_cast<long double>(M_PI) * cycle};
+  switch (shape) {
+    case Shape::Triangle: return static_cast<double>((2.0L / M_PI) * std::asin(std::sin(x)));
+    // a phase on an edge takes the value after it
+    case Shape::Square: return cycle < 0.5 ? 1.0 : -1.0;
+    case Shape::Saw: return cycle < 0.5 ? 2.0 * cycle : 2.0 * cycle - 2.0;
+    default: return static_cast<double>(std::sin(x));
+  }
+}
+
+void reference(Shape const shape, double const freq, int const rate, double* out, std::size_t const size, std::size_t const start) {
+  for (std::size_t i = start; i < start + size; ++i, ++out) {
+    switch (shape) {
+      case Shape::Sine: {
+        *out = std::sin((2.0 * M_PI * (freq / rate * i)));
+        break;
+      }
+      case Shape::Triangle: {
+        *out = (2.0 / M_PI) * std::asin(std::sin((2 * M_PI * (freq / rate)) * i));
+        break;
+      }
+      case Shape::Square: {
+        *out = std::sin((2.0 * M_PI * (freq / rate * i))) >= 0 ? 1.0 : -1.0;
+        break;
+      }
+      default: {
+        *out = (2.0 / M_PI) * std::atan(std::tan(M_PI * (freq / rate * i)));
+        break;
+      }
+    }
+  }
+}
+
+} // namespace OB::Tone
@@ -0,0 +1,531 @@
+/*
+                                    88888888
+                                  888888888888
+                                 88888888888888
+                                8888888888888888
+                               888888888888888888
+                              888888  8888  888888
+                              88888    88    88888
+                              888888  8888  888888
+                              88888888888888888888
+                              88888888888888888888
+                             8888888888888888888888
+                          8888888888888888888888888888
+                        88888888888888888888888888888888
+                              88888888888888888888
+                            888888888888888888888888
+                           888888  8888888888  888888
+                           888     8888  8888     888
+                                   888    888
+
+                                   OCTOBANANA
+
+Licensed under the MIT License
+
+Copyright (c) 2020 Brett Robinson <https://octobanana.com/>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef OB_TONE_HH
+#define OB_TONE_HH
+
+#include "ob/dither.hh"
+#include "ob/kernel.hh"
+#include "ob/filter.hh"
+
+#include <cstddef>
+#include <cstdint>
+
+#include <string>
+#include <memory>
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+namespace OB::Tone {
+
+enum class Shape {
+  Sine,
+  Triangle,
+  Square,
+  Saw,
+};
+
+enum class Phase {
+  Fixed,
+  Float,
+};
+
+// Accuracy tier of the sine, measured against libm in long double over a
+// 60 second 440Hz tone at 44100Hz, SNR is relative to a full-scale sine:
+//   Exact       libm anchored rotation recurrence, max error 2.5e-13, SNR 257dB
+//   Polynomial  degree 9 minimax on the folded phase, max error 4.8e-9, SNR 169dB
+//   Table       2049 entry table with linear interpolation, max error 1.2e-6, SNR 121dB
+// All three are below the 3.1e-5 step of 16-bit output.
+enum class Precision {
+  Exact,
+  Polynomial,
+  Table,
+};
+
+// Treatment of the edges and corners of triangle, square and saw. Polyblep
+// replaces the two frames around each one with their 2-point polynomial
+// band-limited step or ramp, which keeps the near-naive cost and removes most
+// of the aliasing.
+enum class Antialias {
+  None,
+  Polyblep,
+};
+
+// Spectrum of a noise, flat, falling at 3dB per octave, or at 6dB.
+enum class Color {
+  White,
+  Pink,
+  Brown,
+};
+
+Shape to_shape(std::string const& str);
+Phase to_phase(std::string const& str);
+Precision to_precision(std::string const& str);
+Antialias to_antialias(std::string const& str);
+Color to_color(std::string const& str);
+
+// 64-bit fixed-point phase where one cycle spans the full integer range.
+// The phase at any frame is exact, so the frequency never drifts however long
+// the render is, and table lookups can index straight from the high bits.
+class Accumulator {
+public:
+  Accumulator(double const cycles, double const frames);
+  Accumulator() = default;
+  Accumulator(Accumulator&&) = default;
+  Accumulator(Accumulator const&) = default;
+
+  ~Accumulator() = default;
+
+  Accumulator& operator=(Accumulator&&) = default;
+  Accumulator& operator=(Accumulator const&) = default;
+
+  std::uint64_t step() const {
+    return _step;
+  }
+
+  std::uint64_t at(std::size_t const frame) const {
+    return _step * static_cast<std::uint64_t>(frame);
+  }
+
+  static double cycles(std::uint64_t const phase) {
+    return static_cast<double>(phase) * 0x1p-64;
+  }
+
+  template<unsigned int Bits>
+  static std::size_t index(std::uint64_t const phase) {
+    static_assert(Bits > 0 && Bits < 64);
+    return static_cast<std::size_t>(phase >> (64 - Bits));
+  }
+
+  template<unsigned int Bits>
+  static double frac(std::uint64_t const phase) {
+    static_assert(Bits > 0 && Bits < 64);
+    return static_cast<double>(phase << Bits) * 0x1p-64;
+  }
+
+private:
+  std::uint64_t _step {0};
+};
+
+// Band-limited mip-map of a single-cycle waveform with one table per octave.
+// The first level keeps the lowest 'harmonics' harmonics of the cycle and
+// each level after it half as many, down to the fundamental alone, so a tone
+// plays from the richest level whose top harmonic stays below Nyquist. The DC
+// is removed and all levels share one gain that brings the loudest to full
+// scale.
+class Wavetable {
+public:
+  static constexpr std::size_t size {std::size_t {1} << OB::Kernel::lookup_bits};
+  // leaves 16 entries to a period of the top harmonic, so the images of the
+  // linear interpolation stay 47dB below it and fall fast below that
+  static constexpr std::size_t harmonics {size / 16};
+
+  // one cycle of 'frames' samples, 'stride' samples apart
+  Wavetable(double const* cycle, std::size_t const frames, std::size_t const stride = 1);
+  Wavetable(Wavetable&&) = default;
+  Wavetable(Wavetable const&) = default;
+
+  ~Wavetable() = default;
+
+  Wavetable& operator=(Wavetable&&) = default;
+  Wavetable& operator=(Wavetable const&) = default;
+
+  std::size_t levels() const {
+    return _levels.size();
+  }
+
+  // table of 'size' + 1 entries for a tone of 'inc' cycles per frame
+  double const* level(double const inc) const;
+
+private:
+  std::vector<std::vector<double>> _levels;
+};
+
+// Renders normalized samples in the range [-1, 1] for the absolute frame range
+// [start, start + size), the output is a pure function of the frame index.
+// The sine is produced by a rotation recurrence that is reseeded from libm
+// every 'renorm' frames, bounding the accumulated error to about
+// renorm * 2^-52 of full scale. Triangle, square and saw are piecewise-linear
+// functions of the phase with no transcendental calls, all four start at zero
+// and share the phase of the sine fundamental.
+// The polynomial and table precisions evaluate the sine per frame from the
+// phase instead.
+// After 16-bit truncation the output is within 1 LSB of 'analytic', a frame
+// landing exactly on a square or saw edge takes the value after it as there.
+// With Phase::Fixed the phase comes from an Accumulator, otherwise it is
+// derived from the frame index in double precision, which loses resolution
+// as the frame index grows.
+// With Antialias::Polyblep the frames around each edge and corner are
+// corrected after the naive render, the edges are found from the phase of the
+// range alone so the output stays a pure function of the frame index.
+// With an oversample factor the tone is rendered at that multiple of the rate
+// and decimated back with a half-band cascade, each frame from the frames
+// around it, reaching back before frame 0 for the first ones so the output is
+// still a pure function of the frame index.
+class Oscillator {
+public:
+  static constexpr std::size_t renorm {1024};
+
+  Oscillator(Shape const shape, double const freq, int const rate, Phase const phase = Phase::Fixed, Precision const precision = Precision::Exact, Antialias const antialias = Antialias::None, std::size_t const oversample = 1);
+  Oscillator(Oscillator&&) = default;
+  Oscillator(Oscillator const&) = default;
+
+  ~Oscillator() = default;
+
+  Oscillator& operator=(Oscillator&&) = default;
+  Oscillator& operator=(Oscillator const&) = default;
+
+  void render(double* out, std::size_t size, std::size_t start) const;
+
+private:
+  void synth(double* out, std::size_t size, std::size_t start) const;
+  template<Shape S>
+  void render(double* out, std::size_t size, std::size_t start) const;
+  void sine(double* out, std::size_t const size, std::size_t const base, std::size_t const skip) const;
+  template<Shape S>
+  void polyblep(double* out, std::size_t const size, std::size_t const start) const;
+
+  Shape _shape {Shape::Sine};
+  Phase _phase {Phase::Fixed};
+  Precision _precision {Precision::Exact};
+  Antialias _antialias {Antialias::None};
+  Accumulator _acc;
+  double _inc {0};
+  std::shared_ptr<OB::Filter::Decimator const> _decimator;
+};
+
+// Plays a Wavetable, the level for the frequency is read with linear
+// interpolation at the phase a sine Oscillator of the same frequency has.
+class Lookup {
+public:
+  Lookup(std::shared_ptr<Wavetable const> const& table, double const freq, int const rate, Phase const phase = Phase::Fixed);
+  Lookup(Lookup&&) = default;
+  Lookup(Lookup const&) = default;
+
+  ~Lookup() = default;
+
+  Lookup& operator=(Lookup&&) = default;
+  Lookup& operator=(Lookup const&) = default;
+
+  void render(double* out, std::size_t const size, std::size_t const start) const;
+
+private:
+  Phase _phase {Phase::Fixed};
+  Accumulator _acc;
+  double _inc {0};
+  std::shared_ptr<Wavetable const> _table;
+  double const* _level {nullptr};
+};
+
+// Sum of the first 'harmonics' harmonics of a tone with amplitudes of
+// 1 / k^rolloff, leaving out those at or past Nyquist. Each sin(k * x) is
+// stepped from the sine and cosine of the fundamental by the Chebyshev
+// recurrence, and the sum is scaled so its peak over a cycle is full scale.
+// The fundamental comes from the exact rotation recurrence, phase and
+// oversampling work as they do for an Oscillator.
+class Additive {
+public:
+  Additive(std::size_t const harmonics, double const rolloff, double const freq, int const rate, Phase const phase = Phase::Fixed, std::size_t const oversample = 1);
+  Additive(Additive&&) = default;
+  Additive(Additive const&) = default;
+
+  ~Additive() = default;
+
+  Additive& operator=(Additive&&) = default;
+  Additive& operator=(Additive const&) = default;
+
+  void render(double* out, std::size_t size, std::size_t start) const;
+
+private:
+  void synth(double* out, std::size_t size, std::size_t start) const;
+
+  Phase _phase {Phase::Fixed};
+  Accumulator _acc;
+  double _inc {0};
+  std::shared_ptr<std::vector<double> const> _partials;
+  std::shared_ptr<OB::Filter::Decimator const> _decimator;
+};
+
+// Stack of phase-modulated sines, the first operator is the carrier and each
+// one after it modulates the one before it by its index in radians of peak
+// deviation, all at their ratio of the frequency. The top operator also
+// modulates itself by 'feedback' times the mean of its last two frames, the
+// loop restarted a period of the top operator and 'warmup' frames before
+// each chunk of the renorm grid so the output stays a pure function of the
+// frame index. Past a feedback of about 1 the loop has two stable branches
+// over part of each cycle, the period it runs through puts it on the one a
+// single loop through the tone would be on. Every operator is a polynomial
+// sine rendered a block at a time, phase and oversampling work as they do
+// for an Oscillator.
+class Fm {
+public:
+  static constexpr std::size_t warmup {128};
+  // longest period the feedback loop is run through ahead of a chunk
+  static constexpr std::size_t reach {std::size_t {1} << 14};
+
+  Fm(std::vector<double> const& ratios, std::vector<double> const& indexes, double const feedback, double const freq, int const rate, Phase const phase = Phase::Fixed, std::size_t const oversample = 1);
+  Fm(Fm&&) = default;
+  Fm(Fm const&) = default;
+
+  ~Fm() = default;
+
+  Fm& operator=(Fm&&) = default;
+  Fm& operator=(Fm const&) = default;
+
+  void render(double* out, std::size_t size, std::size_t start) const;
+
+  // renders the frames [0, size) at the rate of the operators with one
+  // feedback loop run through them all, started where the first chunk
+  // starts it, the sequential form 'render' restarts on every chunk
+  void reference(double* out, std::size_t const size) const;
+
+private:
+  struct Operator {
+    Accumulator acc;
+    double inc;
+    // peak deviation of the operator below in cycles
+    double depth;
+  };
+
+  void synth(double* out, std::size_t size, std::size_t start) const;
+  void feedback(double* out, std::size_t const size, std::size_t const from) const;
+  void modulate(Operator const& op, double* out, std::size_t const size, double const* mod, double const depth, std::size_t const start) const;
+
+  Phase _phase {Phase::Fixed};
+  std::shared_ptr<std::vector<Operator> const> _operators;
+  double _feedback {0};
+  std::size_t _lead {warmup};
+  std::shared_ptr<OB::Filter::Decimator const> _decimator;
+};
+
+// Noise of a color, the frames are a sum of rows of hashed values keyed by
+// the seed, row k taking a new one every 2^k frames, so any stretch renders
+// on its own. White is the first row alone, pink sums 'rows' of them held
+// between steps after Voss and McCartney, and brown ramps each row to its
+// next value and weighs it by sqrt(2^k), which falls at 6dB per octave
+// without the state of an integrator. The rows past the first two step on a
+// grid 4 times coarser, where they are rendered as the first ones.
+class Noise {
+public:
+  static constexpr std::size_t rows {16};
+
+  Noise(Color const color, std::uint32_t const seed);
+  Noise(Noise&&) = default;
+  Noise(Noise const&) = default;
+
+  ~Noise() = default;
+
+  Noise& operator=(Noise&&) = default;
+  Noise& operator=(Noise const&) = default;
+
+  void render(double* out, std::size_t size, std::size_t start) const;
+
+private:
+  void render(double* out, std::size_t const size, std::uint32_t const counter, std::uint32_t const* keys, double const* weights, std::size_t const count, double* grid) const;
+
+  std::shared_ptr<std::vector<double> const> _weights;
+  std::uint32_t _seed {0};
+  bool _ramp {false};
+};
+
+// Normalized mono samples for the frame range [start, start + size), a pure
+// function of the frame index, such as an Oscillator, a Noise or a stage fed
+// by one.
+using Generator = std::function<void(double* out, std::size_t size, std::size_t start)>;
+
+// Generator playing back a stretch of frames recorded from another, so that
+// several stages reading the same frames share one render of them. Frames
+// outside the stretch are rendered by the generator itself, which makes the
+// stretch a cache that never changes the output.
+class Tape {
+public:
+  explicit Tape(Generator const& gen);
+  Tape(Tape&&) = default;
+  Tape(Tape const&) = default;
+
+  ~Tape() = default;
+
+  Tape& operator=(Tape&&) = default;
+  Tape& operator=(Tape const&) = default;
+
+  // sets the stretch to [start, start + size) and returns the buffer the
+  // caller renders it into
+  double* record(std::size_t const start, std::size_t const size);
+
+  void render(double* out, std::size_t const size, std::size_t const start) const;
+
+private:
+  Generator _gen;
+  std::size_t _start {0};
+  std::vector<double> _frames;
+};
+
+// Rate stage, renders the frames of a generator running at 'from' Hz at
+// 'to' Hz through a Resampler, frame 0 of both falls at the same time.
+// The filter gives the same output from the same frames on every kernel, so
+// the output differs between kernels only where the generator does, as a
+// sine does in its last bits.
+class Resample {
+public:
+  Resample(Generator const& gen, int const from, int const to);
+  Resample(Resample&&) = default;
+  Resample(Resample const&) = default;
+
+  ~Resample() = default;
+
+  Resample& operator=(Resample&&) = default;
+  Resample& operator=(Resample const&) = default;
+
+  OB::Filter::Resampler const& resampler() const {
+    return *_resampler;
+  }
+
+  void render(double* out, std::size_t const size, std::size_t const start) const;
+
+private:
+  Generator _gen;
+  std::shared_ptr<OB::Filter::Resampler const> _resampler;
+};
+
+// Interleaved channel layout of a Source, 'left' and 'right' select which
+// sides of a stereo frame carry the tone, the other is silent.
+struct Layout {
+  std::size_t channels {1};
+  bool left {true};
+  bool right {true};
+};
+
+// Pull-based generator of interleaved frames for the absolute frame range
+// [0, size), with normalized samples multiplied by 'gain', which carries the
+// full scale of the sample format: 16-bit integers are truncated, 32-bit
+// integers rounded, both saturated. An active quantizer instead dithers and
+// rounds every channel on its own. Frames are synthesized in cache-sized
+// blocks on demand, so memory use does not depend on the length of the tone.
+// Given a period, one period is rendered up front and every later frame is
+// copied from it, unless the frames are dithered and never repeat.
+template<typename T>
+class Source {
+public:
+  static constexpr std::size_t block {Oscillator::renorm};
+  // largest period in frames worth keeping for tiling
+  static constexpr std::size_t tile {std::size_t {1} << 20};
+
+  Source(Oscillator const& osc, double const gain, std::size_t const size, Layout const& layout = {}, std::size_t const period = 0, OB::Dither::Quantizer const& quant = {});
+  Source(Generator const& gen, double const gain, std::size_t const size, Layout const& layout = {}, std::size_t const period = 0, OB::Dither::Quantizer const& quant = {});
+  Source(Source&&) = default;
+  Source(Source const&) = default;
+
+  ~Source() = default;
+
+  Source& operator=(Source&&) = default;
+  Source& operator=(Source const&) = default;
+
+  std::size_t channels() const {
+    return _layout.channels;
+  }
+
+  std::size_t size() const {
+    return _size;
+  }
+
+  std::size_t tell() const {
+    return _pos;
+  }
+
+  void seek(std::size_t const frame) {
+    _pos = std::min(frame, _size);
+  }
+
+  // renders up to 'size' frames from the current position and advances it,
+  // returns the number of frames rendered, 0 once the tone has ended
+  std::size_t render(T* out, std::size_t size);
+
+  // renders the frames [start, start + size) without touching the position,
+  // safe to call concurrently
+  void render(T* out, std::size_t size, std::size_t start) const;
+
+private:
+  void synth(T* out, std::size_t size, std::size_t start) const;
+  void dither(T* out, std::size_t size, std::size_t start) const;
+
+  Generator _gen;
+  double _gain {0};
+  std::size_t _size {0};
+  Layout _layout;
+  std::size_t _period {0};
+  OB::Dither::Quantizer _quant;
+  std::vector<T> _tile;
+  std::size_t _pos {0};
+};
+
+extern template class Source<short>;
+extern template class Source<std::int32_t>;
+extern template class Source<float>;
+
+// Number of frames after which a tone of 'freq' Hz at 'rate' Hz repeats
+// exactly, found by reading the frequency as a fraction with a power of ten
+// denominator up to 1000, or 0 when there is none or it exceeds 'limit'.
+std::size_t period(double const freq, int const rate, std::size_t const limit);
+
+// Loop point of a tone of 'freq' Hz at 'rate' Hz, the number of frames up to
+// 'limit' that holds a whole number of cycles with the smallest phase jump,
+// preferring the shortest loop whose jump is within 'tolerance' cycles.
+struct Loop {
+  std::size_t frames {0};
+  double error {0};
+};
+Loop loop(double const freq, int const rate, std::size_t const limit, double const tolerance);
+
+// Normalized value of a shape at a phase in cycles, written independently of
+// the oscillator as the definition it is checked against.
+double analytic(Shape const shape, double const phase);
+
+// Evaluates the closed-form libm expressions for every frame.
+void reference(Shape const shape, double const freq, int const rate, double* out, std::size_t const size, std::size_t const start);
+
+} // namespace OB::Tone
+
+#endif // OB_TONE_HH
@@ -0,0 +1,288 @@
+/*
+                                    88888888
+                                  888888888888
+                                 88888888888888
+                                8888888888888888
+                               888888888888888888
+                              888888  8888  888888
+                              88888    88    88888
+                              888888  8888  888888
+                              88888888888888888888
+                              88888888888888888888
+                             8888888888888888888888
+                          8888888888888888888888888888
+                        88888888888888888888888888888888
+                              88888888888888888888
+                            888888888888888888888888
+                           888888  8888888888  888888
+                           888     8888  8888     888
+                                   888    888
+
+                                   OCTOBANANA
+
+Licensed under the MIT License
+
+Copyright (c) 2020 Brett Robinson <https://octobanana.com/>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "ob/wav.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <string>
+#include <fstream>
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+namespace OB::Wav {
+
+// format tags of the fmt chunk
+static constexpr std::uint16_t tag_pcm {1};
+static constexpr std::uint16_t tag_float {3};
+static constexpr std::uint16_t tag_extensible {0xfffe};
+static constexpr std::uint64_t riff_max {0xffffffffull};
+
+// the sub format guid of WAVE_FORMAT_EXTENSIBLE past its leading format tag
+static constexpr char guid_tail[] {"\x00\x00\x00\x00\x10\x00\x80\x00\x00\xaa\x00\x38\x9b\x71"};
+static constexpr std::size_t guid_tail_size {sizeof(guid_tail) - 1};
+
+// size of the fmt chunk, float carries an empty extension and samples wider
+// than 16 bits take the extensible form with their valid bits
+static std::uint32_t fmt_size(OB::Pcm::Format const format) {
+  switch (format) {
+    case OB::Pcm::Format::F32: return 18;
+    case OB::Pcm::Format::S24: case OB::Pcm::Format::S32: return 40;
+    default: return 16;
+  }
+}
+
+// size of the chunks ahead of the samples, 'RIFF' + 'JUNK' or 'ds64' + 'fmt '
+// + 'fact' for float + 'data'
+static std::uint64_t header_size(OB::Pcm::Format const format) {
+  return 12 + 36 + 8 + fmt_size(format) + (format == OB::Pcm::Format::F32 ? 12 : 0) + 8;
+}
+
+template<typename T>
+static void put(std::string& buf, T const val) {
+  // little endian regardless of the host
+  for (std::size_t i = 0; i < sizeof(T); ++i) {
+    buf += static_cast<char>((static_cast<std::uint64_t>(val) >> (8 * i)) & 0xff);
+  }
+}
+
+// reads 'size' little endian bytes
+static std::uint64_t get(std::string const& buf, std::size_t const pos, std::size_t const size) {
+  std::uint64_t val {0};
+  for (std::size_t i = 0; i < size; ++i) {
+    val |= static_cast<std::uint64_t>(static_cast<unsigned char>(buf[pos + i])) << (8 * i);
+  }
+  return val;
+}
+
+template<typename T>
+static T get(std::string const& buf, std::size_t const pos) {
+  return static_cast<T>(get(buf, pos, sizeof(T)));
+}
+
+Writer::Writer(std::string const& path, int const rate, std::size_t const channels, OB::Pcm::Format const format) :
+  _path {path},
+  _file {path, std::ios::binary | std::ios::trunc},
+  _rate {rate},
+  _channels {channels},
+  _format {format} {
+  if (!_file) {
+    throw std::runtime_error("failed to save audio to '" + _path + "'");
+  }
+  header(false);
+}
+
+Writer::~Writer() {
+  if (_file.is_open()) {
+    try {
+      close();
+    }
+    catch (...) {
+    }
+  }
+}
+
+void Writer::write(char const* data, std::size_t const size) {
+  _file.write(data, static_cast<std::streamsize>(size));
+  if (!_file) {
+    throw std::runtime_error("failed to write audio to '" + _path + "'");
+  }
+  _bytes += size;
+}
+
+void Writer::close() {
+  if (_bytes & 1) {
+    // chunks are padded to an even size
+    _file.put('\0');
+  }
+  _file.seekp(0);
+  header(header_size(_format) - 8 + _bytes + (_bytes & 1) > riff_max);
+  _file.close();
+  if (!_file) {
+    throw std::runtime_error("failed to write audio to '" + _path + "'");
+  }
+}
+
+void Writer::header(bool const rf64) {
+  std::uint64_t const riff_size {header_size(_format) - 8 + _bytes + (_bytes & 1)};
+  std::uint32_t const width {static_cast<std::uint32_t>(OB::Pcm::width(_format))};
+  std::uint32_t const align {static_cast<std::uint32_t>(_channels * width)};
+
+  std::string buf;
+  buf += rf64 ? "RF64" : "RIFF";
+  put(buf, static_cast<std::uint32_t>(rf64 ? riff_max : riff_size));
+  buf += "WAVE";
+
+  // a JUNK chunk holds the place of the ds64 chunk until it is needed
+  buf += rf64 ? "ds64" : "JUNK";
+  put(buf, std::uint32_t {28});
+  put(buf, rf64 ? riff_size : 0);
+  put(buf, rf64 ? _bytes : 0);
+  put(buf, rf64 ? _bytes / align : 0);
+  put(buf, std::uint32_t {0});
+
+  std::uint32_t const size {fmt_size(_format)};
+  std::uint16_t const tag {_format == OB::Pcm::Format::F32 ? tag_float : tag_pcm};
+  buf += "fmt ";
+  put(buf, size);
+  put(buf, size == 40 ? tag_extensible : tag);
+  put(buf, static_cast<std::uint16_t>(_channels));
+  put(buf, static_cast<std::uint32_t>(_rate));
+  put(buf, static_cast<std::uint32_t>(static_cast<std::uint32_t>(_rate) * align));
+  put(buf, static_cast<std::uint16_t>(align));
+  put(buf, static_cast<std::uint16_t>(width * 8));
+  if (size > 16) {
+    put(buf, static_cast<std::uint16_t>(size - 18));
+  }
+  if (size == 40) {
+    // every bit of the container is valid, mono is the front center speaker
+    // and stereo the front left and right
+    put(buf, static_cast<std::uint16_t>(width * 8));
+    put(buf, std::uint32_t {_channels == 1 ? 0x4u : _channels == 2 ? 0x3u : 0x0u});
+    put(buf, tag);
+    buf.append(guid_tail, guid_tail_size);
+  }
+
+  if (_format == OB::Pcm::Format::F32) {
+    // frames per channel, in the ds64 chunk once past 32 bits
+    buf += "fact";
+    put(buf, std::uint32_t {4});
+    put(buf, static_cast<std::uint32_t>(rf64 ? riff_max : _bytes / align));
+  }
+
+  buf += "data";
+  put(buf, static_cast<std::uint32_t>(rf64 ? riff_max : _bytes));
+
+  _file.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+  if (!_file) {
+    throw std::runtime_error("failed to write audio to '" + _path + "'");
+  }
+}
+
+OB::Buffer<double> read(std::string const& path) {
+  std::ifstream file {path, std::ios::binary};
+  if (!file) {
+    throw std::runtime_error("failed to load audio from '" + path + "'");
+  }
+  std::string const buf {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+  auto const invalid = [&]() {
+    return std::runtime_error("invalid wav '" + path + "'");
+  };
+  if (buf.size() < 12 || (buf.compare(0, 4, "RIFF") && buf.compare(0, 4, "RF64")) || buf.compare(8, 4, "WAVE")) {
+    throw invalid();
+  }
+
+  std::uint16_t tag {0};
+  std::size_t channels {0};
+  std::uint32_t rate {0};
+  std::size_t width {0};
+  std::uint64_t rf64_bytes {0};
+  std::size_t data {0};
+  std::uint64_t bytes {0};
+  for (std::size_t pos = 12; pos + 8 <= buf.size();) {
+    std::string const id {buf.substr(pos, 4)};
+    std::uint64_t size {get<std::uint32_t>(buf, pos + 4)};
+    pos += 8;
+    if (id == "ds64" && size >= 16 && pos + 16 <= buf.size()) {
+      rf64_bytes = get<std::uint64_t>(buf, pos + 8);
+    }
+    else if (id == "fmt " && size >= 16 && pos + 16 <= buf.size()) {
+      tag = get<std::uint16_t>(buf, pos);
+      channels = get<std::uint16_t>(buf, pos + 2);
+      rate = get<std::uint32_t>(buf, pos + 4);
+      width = get<std::uint16_t>(buf, pos + 14) / 8u;
+      if (tag == tag_extensible) {
+        // the sub format guid starts with the plain format tag, the samples
+        // sit at the top of their container whatever their valid bits
+        bool const known {size >= 40 && pos + 40 <= buf.size() && !buf.compare(pos + 26, guid_tail_size, guid_tail, guid_tail_size)};
+        tag = known ? get<std::uint16_t>(buf, pos + 24) : 0;
+      }
+    }
+    else if (id == "data") {
+      if (size == riff_max && rf64_bytes) {size = rf64_bytes;}
+      data = pos;
+      bytes = std::min<std::uint64_t>(size, buf.size() - pos);
+      break;
+    }
+    // chunks are padded to an even size
+    pos += size + (size & 1);
+  }
+
+  bool const pcm {tag == tag_pcm && width >= 1 && width <= 4};
+  bool const flt {tag == tag_float && (width == 4 || width == 8)};
+  if (!data || !channels || !rate || rate > 0x7fffffff || (!pcm && !flt)) {
+    throw invalid();
+  }
+
+  std::size_t const frames {static_cast<std::size_t>(bytes / (channels * width))};
+  OB::Buffer<double> audio {channels, static_cast<int>(rate), frames};
+  double* out {audio.data()};
+  for (std::size_t i = 0, pos = data; i < audio.size(); ++i, pos += width) {
+    std::uint64_t const bits {get(buf, pos, width)};
+    if (flt && width == 4) {
+      float val;
+      std::uint32_t const word {static_cast<std::uint32_t>(bits)};
+      std::memcpy(&val, &word, sizeof(val));
+      out[i] = static_cast<double>(val);
+    }
+    else if (flt) {
+      std::memcpy(&out[i], &bits, sizeof(double));
+    }
+    else if (width == 1) {
+      // 8-bit samples are unsigned
+      out[i] = (static_cast<double>(bits) - 128.0) * 0x1p-7;
+    }
+    else {
+      // moved to the top of 32 bits to sign extend
+      out[i] = static_cast<double>(static_cast<std::int32_t>(static_cast<std::uint32_t>(bits << (8 * (4 - width))))) * 0x1p-31;
+    }
+  }
+  return audio;
+}
+
+} // namespace OB::Wav
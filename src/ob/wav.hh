@@ -0,0 +1,99 @@
+/*
+                                    88888888
+                                  888888888888
+                                 88888888888888
+                                8888888888888888
+                               888888888888888888
+                              888888  8888  888888
+                              88888    88    88888
+                              888888  8888  888888
+                              88888888888888888888
+                              88888888888888888888
+                             8888888888888888888888
+                          8888888888888888888888888888
+                        88888888888888888888888888888888
+                              88888888888888888888
+                            888888888888888888888888
+                           888888  8888888888  888888
+                           888     8888  8888     888
+                                   888    888
+
+                                   OCTOBANANA
+
+Licensed under the MIT License
+
+Copyright (c) 2020 Brett Robinson <https://octobanana.com/>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef OB_WAV_HH
+#define OB_WAV_HH
+
+#include "ob/pcm.hh"
+#include "ob/buffer.hh"
+
+#include <cstddef>
+#include <cstdint>
+
+#include <string>
+#include <fstream>
+
+namespace OB::Wav {
+
+// Streams PCM or float frames to a WAV file without holding them in memory.
+// The header reserves room for a ds64 chunk, so when the data outgrows the
+// 32-bit sizes of RIFF the file is finalized as RF64 in place. Float frames
+// carry a fact chunk and integer samples wider than 16 bits are written as
+// WAVE_FORMAT_EXTENSIBLE.
+class Writer {
+public:
+  Writer(std::string const& path, int const rate, std::size_t const channels, OB::Pcm::Format const format = OB::Pcm::Format::S16);
+  Writer(Writer&&) = default;
+  Writer(Writer const&) = delete;
+
+  ~Writer();
+
+  Writer& operator=(Writer&&) = default;
+  Writer& operator=(Writer const&) = delete;
+
+  // appends 'size' bytes of interleaved samples encoded in the format
+  void write(char const* data, std::size_t const size);
+
+  // patches the sizes into the header and closes the file
+  void close();
+
+private:
+  void header(bool const rf64);
+
+  std::string _path;
+  std::ofstream _file;
+  int _rate {0};
+  std::size_t _channels {0};
+  OB::Pcm::Format _format {OB::Pcm::Format::S16};
+  std::uint64_t _bytes {0};
+};
+
+// Loads a whole WAV or RF64 file of 8, 16, 24 or 32-bit integer or 32 or
+// 64-bit float samples, as interleaved samples normalized to [-1, 1].
+OB::Buffer<double> read(std::string const& path);
+
+} // namespace OB::Wav
+
+#endif // OB_WAV_HH